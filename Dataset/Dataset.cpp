@@ -1,10 +1,12 @@
 
 #include <cstdint>
+#include <numeric>
 #include <vector>
 #include <boost/variant.hpp>
 #include "Dataset.h"
 #include "../Generics/Generics.h"
 #include "../Global/GlobalConsts.h"
+#include "../Util/Numa.h"
 
 /// Implementations of Dataset Class
 
@@ -77,6 +79,29 @@ void Dataset::AddClassWeights(const vec_dbl_t &class_weights) {
   meta.wnum_samples = ComputeWNumSamples();
 }
 
+void Dataset::PlaceFeatures(uint32_t numa_options) {
+  numa_options &= NumaInterleaveFeatures | NumaReplicateFeatures;
+  if (numa_options == placement || Numa::NumNodes() == 1)
+    return;
+  placement = numa_options;
+  replicas.clear();
+  if (numa_options & NumaReplicateFeatures) {
+    // each copy is written first, and so allocated, by a thread on its node
+    replicas.resize(Numa::NumNodes());
+    for (uint32_t node = 0; node != replicas.size(); ++node)
+      Numa::RunOnNode(node, [this, node]() {
+        for (const auto &feature: features)
+          replicas[node].emplace_back(std::make_unique<generic_vec_t>(*feature));
+      });
+  } else if (numa_options & NumaInterleaveFeatures) {
+    for (const auto &feature: features)
+      boost::apply_visitor(
+        [] (const auto &feature) {
+          Numa::Interleave(feature.data(), feature.size() * sizeof(feature[0]));
+        }, *feature);
+  }
+}
+
 const MetaData &Dataset::Meta() const {
   return meta;
 }
@@ -86,6 +111,15 @@ uint32_t Dataset::FeatureType(uint32_t feature_idx) const {
 }
 
 const generic_vec_t &Dataset::Features(uint32_t feature_idx) const {
+  if (!replicas.empty())
+    return *replicas[Numa::ThreadNode()][feature_idx];
+  return *features[feature_idx];
+}
+
+const generic_vec_t &Dataset::Features(uint32_t feature_idx,
+                                       uint32_t node) const {
+  if (!replicas.empty())
+    return *replicas[node][feature_idx];
   return *features[feature_idx];
 }
 
@@ -104,6 +138,8 @@ const vec_uint32_t &Dataset::SampleWeights() const {
 template <typename feature_t>
 void Dataset::UpdateFeature(const std::vector<feature_t> &feature,
                             uint32_t feature_type) {
+  replicas.clear();
+  placement = NumaDefault;
   if (meta.size == 0)
     meta.size = static_cast<uint32_t>(feature.size());
   ++meta.num_features;
@@ -118,6 +154,8 @@ void Dataset::UpdateFeature(const std::vector<feature_t> &feature,
 template <typename feature_t>
 void Dataset::UpdateFeatures(const std::vector<std::vector<feature_t>> &features,
                              const vec_uint32_t &feature_types) {
+  replicas.clear();
+  placement = NumaDefault;
   if (meta.size == 0)
     meta.size = static_cast<uint32_t>(features[0].size());
   meta.num_features += features.size();
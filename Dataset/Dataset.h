@@ -10,6 +10,7 @@
 #include "MetaData.h"
 #include "../Generics/TypeDefs.h"
 #include "../Generics/Generics.h"
+#include "../Global/GlobalConsts.h"
 
 /// The class that holds training / testing dataset for either classification or regression.
 /// features and labels are of generic vector type, which can take uin8_t, uint16_t, uint32_t,
@@ -20,7 +21,8 @@ class Dataset {
 
   /// Empty dataset
   Dataset():
-    features(), feature_types(), labels(nullptr), sample_weights(), class_weights(), meta() {}
+    features(), feature_types(), labels(nullptr), sample_weights(), class_weights(), meta(), replicas(),
+    placement(NumaDefault) {}
 
   /// Add a feature vector by copying
   template <typename feature_t>
@@ -59,11 +61,18 @@ class Dataset {
   /// Add class weights
   void AddClassWeights(const vec_dbl_t &class_weights);
 
+  /// Spread the features across the NUMA nodes, or copy them to every node,
+  /// as the NumaInterleaveFeatures and NumaReplicateFeatures bits of numa_options ask
+  void PlaceFeatures(uint32_t numa_options);
+
   ///////////
   /// Getters
   const MetaData &Meta() const;
   uint32_t FeatureType(uint32_t feature_idx) const;
   const generic_vec_t &Features(uint32_t feature_idx) const;
+  /// Features as read on the given NUMA node, for callers that have looked their node up once already
+  const generic_vec_t &Features(uint32_t feature_idx,
+                                uint32_t node) const;
   const generic_vec_t &Labels() const;
   const vec_dbl_t &ClassWeights() const;
   const vec_uint32_t &SampleWeights() const;
@@ -76,6 +85,9 @@ class Dataset {
   vec_uint32_t sample_weights;
   vec_dbl_t class_weights;
   MetaData meta;
+  /// Features copied to each NUMA node, Features returns the copy on Numa::ThreadNode
+  std::vector<std::vector<std::unique_ptr<generic_vec_t>>> replicas;
+  uint32_t placement;
 
   /// Update metadata on added feature
   template <typename feature_t>
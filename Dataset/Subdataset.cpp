@@ -7,23 +7,35 @@
 
 /// Implementation of Subdataset Class
 
-Subdataset::Subdataset(const Dataset *dataset) {
+template <typename weight_t>
+Subdataset::Subdataset(const Dataset *dataset,
+                       const std::vector<weight_t> &sample_weights,
+                       bool route_out_of_bag) {
   num_features = dataset->Meta().num_features;
   trios.resize(num_features);
   sorted_indices.resize(num_features);
-  boost::apply_visitor([this, &dataset] (const auto &labels) {
-    return this->MakeRoot(labels, dataset->SampleWeights(), dataset->Meta().size);
+  boost::apply_visitor([this, &dataset, &sample_weights, route_out_of_bag] (const auto &labels) {
+    return this->MakeRoot(labels, sample_weights, dataset->Meta().size, route_out_of_bag);
   }, dataset->Labels());
 }
 
+/// The weights of the dataset, and the bootstrap weights of a tree
+template Subdataset::Subdataset(const Dataset *dataset,
+                                const vec_uint32_t &sample_weights,
+                                bool route_out_of_bag);
+template Subdataset::Subdataset(const Dataset *dataset,
+                                const vec_uint8_t &sample_weights,
+                                bool route_out_of_bag);
+
 Subdataset::Subdataset(const uint32_t num_features,
                        const uint32_t size,
                        vec_uint32_t &&sample_ids,
                        generic_vec_t &&labels,
-                       vec_uint32_t &&sample_weights):
+                       vec_uint32_t &&sample_weights,
+                       vec_uint32_t &&out_of_bag_ids):
   size(size), num_features(num_features), sample_ids(std::move(sample_ids)),
   labels(std::make_unique<generic_vec_t>(std::move(labels))),
-  sample_weights(std::move(sample_weights)),
+  sample_weights(std::move(sample_weights)), out_of_bag_ids(std::move(out_of_bag_ids)),
   trios(num_features), sorted_indices(num_features) {}
 
 uint32_t Subdataset::Size() const {
@@ -42,6 +54,10 @@ const vec_uint32_t &Subdataset::SampleWeights() const {
   return sample_weights;
 }
 
+const vec_uint32_t &Subdataset::OutOfBagIds() const {
+  return out_of_bag_ids;
+}
+
 const generic_vec_t &Subdataset::Labels() const {
   return *labels;
 }
@@ -115,6 +131,8 @@ void Subdataset::DiscardTemporaryElements() {
   labels.reset();
   sample_weights.clear();
   sample_weights.shrink_to_fit();
+  out_of_bag_ids.clear();
+  out_of_bag_ids.shrink_to_fit();
   for (auto &trio: trios)
     trio.reset();
 }
@@ -123,10 +141,11 @@ bool Subdataset::Empty(uint32_t feature_idx) const {
   return sorted_indices[feature_idx].empty();
 }
 
-template <typename label_t>
+template <typename label_t, typename weight_t>
 void Subdataset::MakeRoot(const std::vector<label_t> &source_labels,
-                          const vec_uint32_t &source_sample_weights,
-                          const uint32_t source_size) {
+                          const std::vector<weight_t> &source_sample_weights,
+                          const uint32_t source_size,
+                          bool route_out_of_bag) {
   /// collect all samples whose sample weights are non-zero
   std::vector<label_t> target_labels;
   target_labels.reserve(source_size);
@@ -139,9 +158,12 @@ void Subdataset::MakeRoot(const std::vector<label_t> &source_labels,
       target_labels.push_back(source_labels[sample_id]);
       sample_weights.push_back(source_sample_weights[sample_id]);
       ++size;
+    } else if (route_out_of_bag) {
+      out_of_bag_ids.push_back(sample_id);
     }
   sample_weights.shrink_to_fit();
   sample_ids.shrink_to_fit();
+  out_of_bag_ids.shrink_to_fit();
   labels = std::make_unique<generic_vec_t>(std::move(target_labels));
 }
 
@@ -190,7 +212,7 @@ Subdataset::PartitionByDiscreteFeature(const SplitInfo *split_info,
     const LowCardDiscriminator<feature_t> discriminator(split_info->info.uint32_type, features);
     PartitionExecutor(discriminator, left_subset, right_subset);
   } else if (split_info->type == IsHighCardinality) {
-    const HighCardDiscriminator<feature_t> discriminator(*(split_info->info.ptr_type), features);
+    const HighCardDiscriminator<feature_t> discriminator(split_info->bitmask, features);
     PartitionExecutor(discriminator, left_subset, right_subset);
   }
 }
@@ -215,6 +237,16 @@ void Subdataset::PartitionExecutor(const Discriminator discriminator,
   right_sample_ids.shrink_to_fit();
   uint32_t left_size = static_cast<uint32_t>(left_sample_ids.size());
 
+  /// partition out-of-bag ids the same way, they keep their ascending order
+  vec_uint32_t left_out_of_bag_ids, right_out_of_bag_ids;
+  for (const auto sample_id: out_of_bag_ids) {
+    if (discriminator(sample_id)) {
+      left_out_of_bag_ids.push_back(sample_id);
+    } else {
+      right_out_of_bag_ids.push_back(sample_id);
+    }
+  }
+
   /// partition labels and sample_weights by the partitioned sample_ids
   auto sample_weights_pair = PartitionBySampleIds(left_sample_ids, sample_weights);
   std::pair<generic_vec_t, generic_vec_t> labels_pair = boost::apply_visitor(
@@ -225,9 +257,11 @@ void Subdataset::PartitionExecutor(const Discriminator discriminator,
 
   /// construct subsets for left and right child
   left_subset = std::make_unique<Subdataset>(num_features, left_size, std::move(left_sample_ids),
-                                             std::move(labels_pair.first), std::move(sample_weights_pair.first));
+                                             std::move(labels_pair.first), std::move(sample_weights_pair.first),
+                                             std::move(left_out_of_bag_ids));
   right_subset = std::make_unique<Subdataset>(num_features, size - left_size, std::move(right_sample_ids),
-                                              std::move(labels_pair.second), std::move(sample_weights_pair.second));
+                                              std::move(labels_pair.second), std::move(sample_weights_pair.second),
+                                              std::move(right_out_of_bag_ids));
 }
 
 template <typename data_t>
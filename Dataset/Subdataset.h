@@ -14,9 +14,13 @@ class Subdataset {
  public:
 
   /// Construct subset from the original dataset.
-  /// Any sample with a non-zero sample weight is subsetted.
+  /// Any sample with a non-zero weight in sample_weights is subsetted, the weights are those of one tree.
+  /// With route_out_of_bag, the ids of the samples of weight zero are kept as well, see OutOfBagIds.
   /// Used to construct subset for root.
-  explicit Subdataset(const Dataset *dataset);
+  template <typename weight_t>
+  Subdataset(const Dataset *dataset,
+             const std::vector<weight_t> &sample_weights,
+             bool route_out_of_bag = false);
 
   /// Construct subset from a given set of sample ids and their corresponding labels and sample weights
   /// These are obtained by partitioning the subset of parent tree node.
@@ -24,7 +28,8 @@ class Subdataset {
              const uint32_t size,
              vec_uint32_t &&sample_ids,
              generic_vec_t &&labels,
-             vec_uint32_t &&sample_weights);
+             vec_uint32_t &&sample_weights,
+             vec_uint32_t &&out_of_bag_ids);
 
   ///////////
   /// Getters
@@ -32,6 +37,7 @@ class Subdataset {
   uint32_t NumFeatures() const;
   const vec_uint32_t &SampleIds() const;
   const vec_uint32_t &SampleWeights() const;
+  const vec_uint32_t &OutOfBagIds() const;
   const generic_vec_t &Labels() const;
   const generic_vec_t &Features(const uint32_t feature_idx) const;
   const vec_uint32_t &SortedIdx(const uint32_t feature_idx) const;
@@ -67,7 +73,7 @@ class Subdataset {
   /// Whether this will be called depends on the memory saving strategy
   void DiscardSortedIdx(const uint32_t feature_idx);
 
-  /// Clear and free memory for sample ids, labels, sample weights and discrete features
+  /// Clear and free memory for labels, sample weights, out-of-bag ids and discrete features
   /// This will be called right after the subset is partitioned
   void DiscardTemporaryElements();
 
@@ -91,6 +97,10 @@ class Subdataset {
   /// Sample weights in the same order as sample ids
   vec_uint32_t sample_weights;
 
+  /// Ids of the samples out of the bag of the tree that reach this subset, in ascending order.
+  /// They go down the tree with the subset, split by the same discriminators, but never count towards a split.
+  vec_uint32_t out_of_bag_ids;
+
   /// Sorted index for the all features, ith element corresponds to the ith feature
   /// For numerical feature, it is constructed by sorting or by subsetting, when that feature is chosen for splitting
   /// For discrete feature, it is always empty
@@ -119,10 +129,11 @@ class Subdataset {
   std::vector<std::unique_ptr<Trio>> trios;
 
   /// Visitor template functions to the root constructor
-  template <typename label_t>
+  template <typename label_t, typename weight_t>
   void MakeRoot(const std::vector<label_t> &source_labels,
-                const vec_uint32_t &source_sample_weights,
-                const uint32_t source_size);
+                const std::vector<weight_t> &source_sample_weights,
+                const uint32_t source_size,
+                bool route_out_of_bag);
 
   /// Generic gather function used to
   /// 1. Gather discrete feature from dataset
@@ -19,4 +19,9 @@ using vec_vec_uint32_t = std::vector<vec_uint32_t>;
 using vec_vec_flt_t = std::vector<vec_flt_t>;
 using vec_vec_dbl_t = std::vector<vec_dbl_t>;
 
+/// Element of the flat N x C class probability buffers, row i holds the C classes of sample i.
+/// float halves the buffers at the cost of precision in the sums over trees.
+using prob_t = double;
+using vec_prob_t = std::vector<prob_t>;
+
 #endif
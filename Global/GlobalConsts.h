@@ -16,11 +16,58 @@ static const float SubsetToSortRatio = 4.0;
 /// Preference of memory saving at the expense of speed
 static const float MemorySavingFactor = 3.0;
 
+/// Size of the table of n log n for integral weighted counts, larger or fractional counts compute the log
+static const uint32_t NLogNTableSize = 65536;
+
 /// Threshold of switching from parallel split finding to serial split finding
 static const uint32_t MaxSizeForSerialSplit = 50000;
 
-/// Threshold of switching from brute force to heuristic to find split in many-vs-many discrete feature
-static const uint32_t MaxNumBinsForBruteSplitter = 8;
+/// Threshold of switching from brute force to heuristic to find split in many-vs-many discrete feature,
+/// whether the brute force search runs in one job or is cut into parallel jobs
+static const uint32_t MaxNumBinsForBruteSplitter = 20;
+
+/// Number of bin assignments enumerated by each job of a parallel brute force search
+static const uint32_t NumFlipsPerBruteRange = 8192;
+
+/// Relative slack when comparing a gain upper bound with the best gain found so far,
+/// covers the rounding difference between the bound and the gain an actual scan would compute
+static const double GainBoundSlack = 1e-9;
+
+/// Nodes of at least this size offer their jobs to the shared priority lane of the job queue rather than to the
+/// deque of a worker, UINT32_MAX keeps every node job in the worker deques
+static const uint32_t MinSizeForPriorityLane = 500000;
+
+/// Under the largest subset first and estimated work first policies, nodes of at least this size are ordered in the
+/// priority lane, smaller ones stay in the worker deques
+static const uint32_t MinSizeForOrderedLane = 10000;
+
+/// Backoff of a worker without a job doubles up to 2^MaxBackoffShift yields,
+/// the worker parks once it has spun for MaxSpinMicroseconds, a yield may hand the CPU over for a whole time slice
+static const uint32_t MaxBackoffShift = 6;
+static const uint32_t MaxSpinMicroseconds = 200;
+
+/// NUMA placement options, bits that can be combined. Replicated features take precedence over interleaved ones.
+static const uint32_t NumaDefault = 0x0;
+static const uint32_t NumaPinWorkers = 0x1;
+static const uint32_t NumaInterleaveFeatures = 0x2;
+static const uint32_t NumaReplicateFeatures = 0x4;
+
+/// Each worker samples the number of queued jobs once every NumJobsPerQueueDepthSample jobs it runs
+static const uint32_t NumJobsPerQueueDepthSample = 64;
+
+/// With tracing on, each worker keeps the last NumTraceEventsPerWorker jobs it ran
+static const uint32_t NumTraceEventsPerWorker = 65536;
+
+/// Tree parallelism of a forest left to ForestBuildDriver, which starts NumTreesAtForestStart trees on all workers
+/// and starts another when the job queue runs low or a worker goes idle, up to one tree per worker
+static const uint32_t AdaptiveTreeParallelism = 0;
+static const uint32_t NumTreesAtForestStart = 2;
+
+/// A bootstrap is drawn in chunks of NumSamplesPerBootstrapChunk samples, one Philox stream and one task per chunk
+static const uint32_t NumSamplesPerBootstrapChunk = 65536;
+
+/// The sums over trees are split into ranges of NumSamplesPerOutputRange samples, each owned by one worker at a time
+static const uint32_t NumSamplesPerOutputRange = 16384;
 
 /// Max number of bins to test in each step in the move-one-bin-at-a-time heuristic split finding algorithm
 static const uint32_t MaxNumBinsForSampling = 16;
@@ -52,6 +99,15 @@ static const uint32_t Entropy = 1;
 static const uint32_t GiniImpurity = 2;
 static const uint32_t Variance = 3;
 
+/// Scheduling Policy ID
+static const uint32_t LocalFirst = 0;
+static const uint32_t LargestSubsetFirst = 1;
+static const uint32_t EstimatedWorkFirst = 2;
+
+/// Bootstrap Mode, n draws with replacement out of n samples, or an independent Poisson(1) weight for each sample
+static const uint32_t BootstrapMultinomial = 0;
+static const uint32_t BootstrapPoisson = 1;
+
 /// Predict Options
 static const uint32_t PredictAll = 0;
 static const uint32_t PredictPresent = 1;
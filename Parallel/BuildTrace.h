@@ -0,0 +1,90 @@
+
+#ifndef DECISIONTREE_BUILDTRACE_H
+#define DECISIONTREE_BUILDTRACE_H
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+#include "SchedulerStats.h"
+
+/// Timeline of the jobs of one build, written in the Chrome trace event format for chrome://tracing or Perfetto.
+/// Each worker appends to its own ring buffer, which keeps its last NumTraceEventsPerWorker events, so recording
+/// takes no lock and no atomic. The buffers are only read once the workers are done.
+class BuildTrace {
+ public:
+  struct Event {
+    uint64_t begin;
+    uint64_t end;
+    uint32_t type;
+    uint32_t depth;
+    uint32_t size;
+    uint32_t feature_idx;
+  };
+
+  /// No feature for the event
+  static const uint32_t NoFeature = UINT32_MAX;
+
+  BuildTrace():
+    rings(), origin(0) {}
+
+  void Init(uint32_t num_workers,
+            uint32_t num_events_per_worker) {
+    rings.assign(num_workers, Ring(num_events_per_worker));
+    origin = SchedulerStats::Now();
+  }
+
+  void Add(uint32_t worker_idx,
+           const Event &event) {
+    Ring &ring = rings[worker_idx];
+    ring.events[ring.num_events++ % ring.events.size()] = event;
+  }
+
+  bool Empty() const {
+    return rings.empty();
+  }
+
+  /// One complete event per job, timed in microseconds since Init, with one thread per worker
+  void WriteJson(std::ostream &out) const {
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    for (uint32_t worker_idx = 0; worker_idx != rings.size(); ++worker_idx) {
+      const std::vector<Event> &events = rings[worker_idx].events;
+      uint64_t end_idx = rings[worker_idx].num_events;
+      uint64_t begin_idx = (end_idx > events.size())? end_idx - events.size() : 0;
+      for (uint64_t idx = begin_idx; idx != end_idx; ++idx) {
+        const Event &event = events[idx % events.size()];
+        out << (first? "" : ",\n") << "{\"name\": \"" << SchedulerStats::JobTypeName(event.type)
+            << "\", \"cat\": \"build\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << worker_idx
+            << ", \"ts\": " << 1e-3 * (event.begin - origin) << ", \"dur\": " << 1e-3 * (event.end - event.begin)
+            << ", \"args\": {\"depth\": " << event.depth << ", \"size\": " << event.size;
+        if (event.feature_idx != NoFeature)
+          out << ", \"feature\": " << event.feature_idx;
+        out << "}}";
+        first = false;
+      }
+    }
+    out << "]}" << std::endl;
+    out.flags(flags);
+  }
+
+ private:
+  static const uint32_t CacheLineSize = 64;
+
+  /// Written by one worker only. The vector does not align the rings to cache lines, so a whole line of padding
+  /// keeps the rings of two workers off any one line.
+  struct Ring {
+    std::vector<Event> events;
+    uint64_t num_events;
+    char padding[CacheLineSize];
+
+    explicit Ring(uint32_t num_events_per_worker):
+      events(num_events_per_worker), num_events(0), padding() {}
+  };
+
+  std::vector<Ring> rings;
+  uint64_t origin;
+};
+
+#endif
@@ -0,0 +1,196 @@
+
+#ifndef DECISIONTREE_EPOCHRECLAIMER_H
+#define DECISIONTREE_EPOCHRECLAIMER_H
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+/// Epoch based reclamation (Fraser, Practical lock-freedom, 2004) of the nodes of lock-free structures.
+/// Threads access the nodes inside a Guard. A node retired in epoch e is unreachable for threads that enter
+/// after it was unlinked, and the global epoch cannot pass e + 1 while a thread that entered earlier is inside,
+/// so the node is recycled once the epoch reaches e + 2. The epoch only advances when every thread inside a Guard
+/// has entered in the current one.
+/// Recycled nodes go to a free list of the thread, which is capped so that memory stays flat.
+template <typename NodeType>
+class EpochReclaimer {
+
+  static const uint32_t NumEpochs = 3;
+  static const uint32_t RetiresPerAdvance = 64;
+  static const uint32_t MaxNumFreeNodes = 1024;
+
+  /// One per thread using the reclaimer, taken over by a later thread after the owner exits
+  struct Record {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> active;
+    std::atomic<bool> in_use;
+    Record *next;
+    uint32_t nesting;
+    uint32_t num_retired;
+    uint64_t retired_epochs[NumEpochs];
+    std::vector<NodeType *> retired[NumEpochs];
+    std::vector<NodeType *> free_nodes;
+
+    Record():
+      epoch(0), active(false), in_use(true), next(nullptr), nesting(0), num_retired(0), retired_epochs(), retired(),
+      free_nodes() {}
+  };
+
+ public:
+  static EpochReclaimer &GetInstance() {
+    static EpochReclaimer<NodeType> instance;
+    return instance;
+  }
+
+  class Guard {
+   public:
+    explicit Guard(EpochReclaimer &reclaimer):
+      reclaimer(reclaimer) {
+      reclaimer.Enter();
+    }
+
+    ~Guard() {
+      reclaimer.Exit();
+    }
+
+   private:
+    EpochReclaimer &reclaimer;
+  };
+
+  /// Reuse a recycled node if there is one, inside a Guard
+  template <typename... Args>
+  NodeType *Allocate(const Args &... args) {
+    Record *record = LocalRecord();
+    if (record->free_nodes.empty())
+      return new NodeType(args...);
+    NodeType *node = record->free_nodes.back();
+    record->free_nodes.pop_back();
+    node->Reset(args...);
+    return node;
+  }
+
+  /// Recycle a node that was never reachable from other threads
+  void Recycle(NodeType *node) {
+    Free(LocalRecord(), node);
+  }
+
+  /// Recycle an unlinked node once no thread can still be reading it, inside a Guard
+  void Retire(NodeType *node) {
+    Record *record = LocalRecord();
+    // the global epoch rather than the one the thread entered in, which may already be behind when the node is unlinked
+    uint64_t epoch = global_epoch.load();
+    uint32_t idx = epoch % NumEpochs;
+    if (record->retired_epochs[idx] != epoch) {
+      FreeRetired(record, idx);
+      record->retired_epochs[idx] = epoch;
+    }
+    record->retired[idx].push_back(node);
+    if (++record->num_retired % RetiresPerAdvance == 0)
+      TryAdvance();
+  }
+
+  ~EpochReclaimer() {
+    for (Record *record = records.load(); record != nullptr;) {
+      for (auto &retired: record->retired)
+        for (auto *node: retired)
+          delete node;
+      for (auto *node: record->free_nodes)
+        delete node;
+      Record *next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+ private:
+  /// Gives the record of a thread back when the thread exits
+  struct RecordHandle {
+    EpochReclaimer *reclaimer;
+    Record *record;
+
+    ~RecordHandle() {
+      if (record) reclaimer->ReleaseRecord(record);
+    }
+  };
+
+  std::atomic<uint64_t> global_epoch;
+  std::atomic<Record *> records;
+
+  EpochReclaimer():
+    global_epoch(0), records(nullptr) {}
+
+  Record *LocalRecord() {
+    static thread_local RecordHandle handle{this, nullptr};
+    if (!handle.record)
+      handle.record = AcquireRecord();
+    return handle.record;
+  }
+
+  Record *AcquireRecord() {
+    for (Record *record = records.load(); record != nullptr; record = record->next) {
+      bool in_use = false;
+      if (!record->in_use.load(std::memory_order_relaxed) &&
+          record->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire, std::memory_order_relaxed))
+        return record;
+    }
+    auto *record = new Record();
+    Record *head = records.load();
+    do {
+      record->next = head;
+    } while (!records.compare_exchange_weak(head, record));
+    return record;
+  }
+
+  /// Free nodes belong to no one, retired nodes stay with the record for the thread that takes it over
+  void ReleaseRecord(Record *record) {
+    for (auto *node: record->free_nodes)
+      delete node;
+    record->free_nodes.clear();
+    record->free_nodes.shrink_to_fit();
+    record->in_use.store(false, std::memory_order_release);
+  }
+
+  void Enter() {
+    Record *record = LocalRecord();
+    if (record->nesting++ != 0)
+      return;
+    uint64_t epoch = global_epoch.load(std::memory_order_relaxed);
+    record->epoch.store(epoch, std::memory_order_relaxed);
+    record->active.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (uint32_t idx = 0; idx != NumEpochs; ++idx)
+      if (record->retired_epochs[idx] + 2 <= epoch)
+        FreeRetired(record, idx);
+  }
+
+  void Exit() {
+    Record *record = LocalRecord();
+    if (--record->nesting == 0)
+      record->active.store(false, std::memory_order_release);
+  }
+
+  void TryAdvance() {
+    uint64_t epoch = global_epoch.load();
+    for (Record *record = records.load(); record != nullptr; record = record->next)
+      if (record->active.load() && record->epoch.load() != epoch)
+        return;
+    global_epoch.compare_exchange_strong(epoch, epoch + 1);
+  }
+
+  void FreeRetired(Record *record,
+                   uint32_t idx) {
+    for (auto *node: record->retired[idx])
+      Free(record, node);
+    record->retired[idx].clear();
+  }
+
+  void Free(Record *record,
+            NodeType *node) {
+    if (record->free_nodes.size() < MaxNumFreeNodes)
+      record->free_nodes.push_back(node);
+    else
+      delete node;
+  }
+};
+
+#endif
@@ -8,16 +8,18 @@
 #include "../Generics/TypeDefs.h"
 #include "../Tree/TreeNode.h"
 
+/// tree_id tells apart the trees of a forest built on one job queue, see ForestBuildDriver
 class Job {
  public:
   static const uint32_t MinValue = 0;
   static const uint32_t WriteToTree = 1;
   static const uint32_t MakeLeaf = 2;
-  static const uint32_t FindSplitOnOneFeature = 3;
-  static const uint32_t FindSplitOnAllFeatures = 4;
-  static const uint32_t DoSplit = 5;
-  static const uint32_t InitSplit = 6;
-  static const uint32_t SetupRoot = 7;
+  static const uint32_t FindSplitOnBinRange = 3;
+  static const uint32_t FindSplitOnOneFeature = 4;
+  static const uint32_t FindSplitOnAllFeatures = 5;
+  static const uint32_t DoSplit = 6;
+  static const uint32_t InitSplit = 7;
+  static const uint32_t SetupRoot = 8;
   static const uint32_t Idle = UINT32_MAX - 1;
   static const uint32_t MaxValue = UINT32_MAX;
 
@@ -25,6 +27,12 @@ class Job {
   uint32_t tree_id;
   TreeNode *node;
   uint32_t feature_idx;
+  uint32_t candidate_idx;
+  uint32_t range_idx;
+  /// Set by the scheduling policy for jobs offered to the priority lane, higher runs first
+  uint64_t priority;
+  /// Set when the job is queued, in nanoseconds of the steady clock
+  uint64_t offer_time;
 
   static Job Min() {
     Job job;
@@ -32,6 +40,10 @@ class Job {
     job.tree_id = 0;
     job.node = nullptr;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = UINT64_MAX;
+    job.offer_time = 0;
     return job;
   }
 
@@ -41,6 +53,10 @@ class Job {
     job.tree_id = 0;
     job.node = nullptr;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
@@ -50,6 +66,10 @@ class Job {
     job.tree_id = 0;
     job.node = nullptr;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
@@ -59,34 +79,71 @@ class Job {
     job.tree_id = tree_id;
     job.node = nullptr;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
-  static Job InitSplitJob(TreeNode *node) {
+  static Job InitSplitJob(TreeNode *node,
+                          uint32_t tree_id = 0) {
     Job job;
     job.type = InitSplit;
-    job.tree_id = 0;
+    job.tree_id = tree_id;
     job.node = node;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
   static Job FindSplitOnOneFeatureJob(TreeNode *node,
-                                      uint32_t feature_idx) {
+                                      uint32_t feature_idx,
+                                      uint32_t candidate_idx,
+                                      uint32_t tree_id = 0) {
     Job job;
     job.type = FindSplitOnOneFeature;
-    job.tree_id = 0;
+    job.tree_id = tree_id;
     job.node = node;
     job.feature_idx = feature_idx;
+    job.candidate_idx = candidate_idx;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
-  static Job DoSplitJob(TreeNode *node) {
+  static Job FindSplitOnBinRangeJob(TreeNode *node,
+                                    uint32_t feature_idx,
+                                    uint32_t candidate_idx,
+                                    uint32_t range_idx,
+                                    uint32_t tree_id = 0) {
+    Job job;
+    job.type = FindSplitOnBinRange;
+    job.tree_id = tree_id;
+    job.node = node;
+    job.feature_idx = feature_idx;
+    job.candidate_idx = candidate_idx;
+    job.range_idx = range_idx;
+    job.priority = 0;
+    job.offer_time = 0;
+    return job;
+  }
+
+  static Job DoSplitJob(TreeNode *node,
+                        uint32_t tree_id = 0) {
     Job job;
     job.type = DoSplit;
-    job.tree_id = 0;
+    job.tree_id = tree_id;
     job.node = node;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
@@ -96,6 +153,10 @@ class Job {
     job.tree_id = tree_id;
     job.node = nullptr;
     job.feature_idx = 0;
+    job.candidate_idx = 0;
+    job.range_idx = 0;
+    job.priority = 0;
+    job.offer_time = 0;
     return job;
   }
 
@@ -109,12 +170,16 @@ class Job {
   }
 
   bool operator<(const Job &job) const {
-    if (this->type != job.type) {
+    if (this->priority != job.priority) {
+      return this->priority > job.priority;
+    } else if (this->type != job.type) {
       return this->type < job.type;
     } else if (this->tree_id != job.tree_id) {
       return this->tree_id < job.tree_id;
     } else if (this->feature_idx != job.feature_idx) {
       return this->feature_idx < job.feature_idx;
+    } else if (this->range_idx != job.range_idx) {
+      return this->range_idx < job.range_idx;
     } else if (this->type == DoSplit) {
       return this->node->Split()->gain > job.node->Split()->gain;
     } else {
@@ -127,7 +192,8 @@ class Job {
   }
 
   bool operator==(const Job &job) const {
-    return type == job.type && tree_id == job.tree_id && node == job.node && feature_idx == job.feature_idx;
+    return type == job.type && tree_id == job.tree_id && node == job.node && feature_idx == job.feature_idx &&
+           range_idx == job.range_idx;
   }
 
  private:
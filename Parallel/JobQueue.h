@@ -3,41 +3,235 @@
 #define DECISIONTREE_SYNCJOBQUEUE_H
 
 #include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../Global/GlobalConsts.h"
 #include "../Generics/TypeDefs.h"
 #include "LockFreeSkipList.h"
+#include "WorkStealingDeque.h"
 #include "Job.h"
 
+/// Jobs are pushed to the deque of the worker that created them and stolen by idle workers.
+/// Jobs that should not wait behind the work of one worker are offered to a shared priority lane,
+/// which is polled first whenever it is not empty.
+/// Workers steal first from workers on their own NUMA node, whose jobs work on subsets written, and so allocated,
+/// on that node.
+/// A worker that finds no job backs off exponentially for a while, then parks until a job comes in.
+/// Before it parks it calls the idle handler, if any, which may offer more work.
 template <typename JobType>
 class JobQueue {
  public:
-  static JobQueue &GetInstance() {
-    static JobQueue<JobType> instance;
-    return instance;
+  JobQueue():
+    lane(), num_lane_jobs(0), deques(), worker_nodes(), finished(false), park_mut(), cv_park(), num_parked(0),
+    counters(), idle_handler() {}
+
+  /// Set up one deque per worker, workers are numbered from 0 to num_workers - 1
+  void Init(uint32_t num_workers) {
+    deques.clear();
+    for (uint32_t worker_idx = 0; worker_idx != num_workers; ++worker_idx)
+      deques.emplace_back(new WorkStealingDeque<JobType>());
+    worker_nodes.reset(new std::atomic<uint32_t>[num_workers]);
+    for (uint32_t worker_idx = 0; worker_idx != num_workers; ++worker_idx)
+      worker_nodes[worker_idx] = 0;
+    finished = false;
+    counters.assign(num_workers, WorkerCounters());
+  }
+
+  /// Record the NUMA node a worker runs on
+  void SetNode(uint32_t worker_idx,
+               uint32_t node) {
+    worker_nodes[worker_idx] = node;
+  }
+
+  /// Called with the index of a worker that has spun for MaxSpinMicroseconds without a job, on that worker.
+  /// A job the handler offers or pushes is found before the worker parks.
+  void SetIdleHandler(const std::function<void(uint32_t)> &idle_handler) {
+    this->idle_handler = idle_handler;
   }
 
+  /// Offer to the priority lane, from any thread
   void Offer(const JobType &job) {
-    jobs.Insert(job);
+    ++num_lane_jobs;
+    if (!lane.Insert(job))
+      --num_lane_jobs;
+    WakeOne();
   }
 
-  bool Poll(JobType &output) {
-    while (!jobs.Poll(output) && !finished)
-      Backoff();
+  /// Push to the deque of the calling worker
+  void Push(uint32_t worker_idx,
+            const JobType &job) {
+    deques[worker_idx]->Push(job);
+    WakeOne();
+  }
+
+  bool Poll(uint32_t worker_idx,
+            JobType &output) {
+    if (TryPoll(worker_idx, output))
+      return finished;
+    uint64_t &spin_nanoseconds = counters[worker_idx].spin_nanoseconds;
+    auto spin_begin = Clock::now();
+    uint32_t num_spins = 0;
+    while (!finished) {
+      if (Clock::now() - spin_begin < std::chrono::microseconds(MaxSpinMicroseconds)) {
+        Backoff(num_spins++);
+        if (TryPoll(worker_idx, output))
+          break;
+      } else {
+        AddTime(spin_nanoseconds, spin_begin);
+        if (idle_handler)
+          idle_handler(worker_idx);
+        bool found = Park(worker_idx, output);
+        spin_begin = Clock::now();
+        num_spins = 0;
+        if (found)
+          break;
+      }
+    }
+    AddTime(spin_nanoseconds, spin_begin);
     return finished;
   }
 
   void SetFinish() {
     finished = true;
+    std::lock_guard<std::mutex> lock(park_mut);
+    cv_park.notify_all();
+  }
+
+  /// Time workers spent looking for a job since Init, busy and parked, in seconds.
+  /// Counters of the workers are only to be read once they are done.
+  double SpinTime() const {
+    uint64_t nanoseconds = 0;
+    for (const auto &worker_counters: counters)
+      nanoseconds += worker_counters.spin_nanoseconds;
+    return nanoseconds * 1e-9;
+  }
+
+  double ParkedTime() const {
+    uint64_t nanoseconds = 0;
+    for (const auto &worker_counters: counters)
+      nanoseconds += worker_counters.parked_nanoseconds;
+    return nanoseconds * 1e-9;
+  }
+
+  double SpinTime(uint32_t worker_idx) const {
+    return counters[worker_idx].spin_nanoseconds * 1e-9;
+  }
+
+  double ParkedTime(uint32_t worker_idx) const {
+    return counters[worker_idx].parked_nanoseconds * 1e-9;
+  }
+
+  uint64_t NumSteals(uint32_t worker_idx) const {
+    return counters[worker_idx].num_steals;
+  }
+
+  uint64_t NumLanePolls(uint32_t worker_idx) const {
+    return counters[worker_idx].num_lane_polls;
+  }
+
+  /// Jobs waiting in the lane and the deques, approximately while workers are running
+  uint32_t Depth() const {
+    auto depth = static_cast<uint32_t>(std::max(num_lane_jobs.load(std::memory_order_relaxed), 0));
+    for (const auto &deque: deques)
+      depth += deque->Size();
+    return depth;
   }
 
  private:
-  LockFreeSkipList<JobType> jobs;
-  bool finished;
+  LockFreeSkipList<JobType> lane;
+  /// Counted ahead of insertion, so that an empty lane is seen without touching the head of the skip list
+  std::atomic<int32_t> num_lane_jobs;
+  std::vector<std::unique_ptr<WorkStealingDeque<JobType>>> deques;
+  std::unique_ptr<std::atomic<uint32_t>[]> worker_nodes;
+  std::atomic<bool> finished;
+
+  std::mutex park_mut;
+  std::condition_variable cv_park;
+  std::atomic<uint32_t> num_parked;
+
+  static const uint32_t CacheLineSize = 64;
+
+  /// Each worker writes only its own. The vector does not align them to cache lines, so a whole line of padding
+  /// keeps the counters of two workers off any one line.
+  struct WorkerCounters {
+    uint64_t spin_nanoseconds;
+    uint64_t parked_nanoseconds;
+    uint64_t num_steals;
+    uint64_t num_lane_polls;
+    char padding[CacheLineSize];
+
+    WorkerCounters():
+      spin_nanoseconds(0), parked_nanoseconds(0), num_steals(0), num_lane_polls(0), padding() {}
+  };
+
+  std::vector<WorkerCounters> counters;
+  std::function<void(uint32_t)> idle_handler;
 
-  explicit JobQueue():
-    jobs(), finished(false) {}
+  using Clock = std::chrono::steady_clock;
+
+  bool TryPoll(uint32_t worker_idx,
+               JobType &output) {
+    if (num_lane_jobs.load(std::memory_order_relaxed) > 0 && lane.Poll(output)) {
+      --num_lane_jobs;
+      ++counters[worker_idx].num_lane_polls;
+      return true;
+    }
+    if (deques[worker_idx]->Pop(output))
+      return true;
+    auto num_workers = static_cast<uint32_t>(deques.size());
+    uint32_t node = worker_nodes[worker_idx].load(std::memory_order_relaxed);
+    for (uint32_t pass = 0; pass != 2; ++pass)
+      for (uint32_t offset = 1; offset < num_workers; ++offset) {
+        uint32_t victim_idx = (worker_idx + offset) % num_workers;
+        bool is_local = worker_nodes[victim_idx].load(std::memory_order_relaxed) == node;
+        if (is_local == (pass == 0) && deques[victim_idx]->Steal(output)) {
+          ++counters[worker_idx].num_steals;
+          return true;
+        }
+      }
+    return false;
+  }
+
+  void Backoff(uint32_t num_spins) {
+    for (uint32_t idx = 0; idx != 1u << std::min(num_spins, MaxBackoffShift); ++idx)
+      std::this_thread::yield();
+  }
+
+  /// Announce the parking before the last look for a job, a worker offering a job at the same time either
+  /// sees the announcement or has its job found
+  bool Park(uint32_t worker_idx,
+            JobType &output) {
+    auto park_begin = Clock::now();
+    std::unique_lock<std::mutex> lock(park_mut);
+    ++num_parked;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool found = TryPoll(worker_idx, output);
+    if (!found && !finished)
+      cv_park.wait(lock);
+    --num_parked;
+    lock.unlock();
+    AddTime(counters[worker_idx].parked_nanoseconds, park_begin);
+    return found;
+  }
+
+  void WakeOne() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_parked.load(std::memory_order_relaxed) == 0)
+      return;
+    std::lock_guard<std::mutex> lock(park_mut);
+    cv_park.notify_one();
+  }
 
-  void Backoff() {
-    // do nothing
+  static void AddTime(uint64_t &nanoseconds,
+                      Clock::time_point begin) {
+    nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
   }
 };
 
@@ -6,73 +6,79 @@
 #include <memory>
 #include <random>
 #include "AtomicMarkablePtr.h"
+#include "EpochReclaimer.h"
 #include "Job.h"
 #include "SkipListNode.h"
 
+/// Nodes are only read inside a Guard of the reclaimer, an unlinked node is retired to it by whichever of its
+/// insert and its removal finishes last, and comes back from it through Allocate.
 template <typename ItemType>
 class LockFreeSkipList {
 
 using Node = SkipListNode<ItemType>;
+using Reclaimer = EpochReclaimer<Node>;
+using Guard = typename Reclaimer::Guard;
 
  public:
   LockFreeSkipList():
-    head(Node::GetHead()), tail(Node::GetTail()), rand_gen(), dist(0, Node::InverseProb - 1) {
+    reclaimer(Reclaimer::GetInstance()), head(new Node(ItemType::Min(), Node::MaxLevel)),
+    tail(new Node(ItemType::Max(), Node::MaxLevel)), rand_gen(), dist(0, Node::InverseProb - 1) {
     for (uint32_t level = 0; level <= Node::MaxLevel; ++level)
-      head->next[level] = tail;
+      head->next[level] = tail.get();
+  }
+
+  /// Nodes still in the list, nothing else may use the list by now
+  ~LockFreeSkipList() {
+    Node *curr = head->next[0].Get();
+    while (curr != tail.get()) {
+      Node *next = curr->next[0].Get();
+      delete curr;
+      curr = next;
+    }
   }
 
   bool Insert(const ItemType &item) {
+    Guard guard(reclaimer);
     uint32_t top_level = RandomLevel();
-    std::vector<Node *> preds(Node::MaxLevel + 1, nullptr);
-    std::vector<Node *> succs(Node::MaxLevel + 1, nullptr);
-    while (!Find(item, preds, succs)) {
-      auto *node = Node::GetNode(item, top_level);
+    Node *preds[Node::MaxLevel + 1];
+    Node *succs[Node::MaxLevel + 1];
+    Node *node = nullptr;
+    while (true) {
+      if (Find(item, preds, succs)) {
+        if (node) reclaimer.Recycle(node);
+        return false;
+      }
+      if (!node) node = reclaimer.Allocate(item, top_level);
       for (uint32_t level = 0; level <= top_level; ++level)
-         node->next[level] = succs[level];
-      if (!preds[0]->next[0].CompareAndSet(succs[0], node, false, false))
-        continue;
-      for (uint32_t level = 1; level <= top_level; ++level)
-          while (!preds[level]->next[level].CompareAndSet(succs[level], node, false, false))
-            Find(item, preds, succs);
-      return true;
+        node->next[level] = succs[level];
+      if (preds[0]->next[0].CompareAndSet(succs[0], node, false, false))
+        break;
     }
-    return false;
+    for (uint32_t level = 1; level <= top_level && LinkLevel(node, level, preds, succs); ++level);
+    // a removal that finished before the node was linked on every level may have left links behind
+    if (node->next[0].GetMark())
+      Find(item, preds, succs, true);
+    Release(node);
+    return true;
   }
 
   bool Erase(const ItemType &item) {
-    std::vector<Node *> preds(Node::MaxLevel + 1, nullptr);
-    std::vector<Node *> succs(Node::MaxLevel + 1, nullptr);
-    while (Find(item, preds, succs)) {
-      Node *node = succs[0];
-      for (uint32_t level = node->top_level; level != 0; --level) {
-        bool mark = false;
-        auto *succ = node->next[level].Get(mark);
-        while (!mark) {
-          node->next[level].CompareAndSet(succ, succ, false, true);
-          succ = node->next[level].Get(mark);
-        }
-      }
-      bool mark = false;
-      auto *succ = node->next[0].Get(mark);
-      while (true) {
-        bool i_am_the_marker = node->next[0].CompareAndSet(succ, succ, false, true);
-        succ = node->next[0].Get(mark);
-        if (i_am_the_marker) {
-          Find(item, preds, succs);
-          return true;
-        } else if (mark) {
-          return false;
-        }
-      }
-    }
-    return false;
+    Guard guard(reclaimer);
+    Node *preds[Node::MaxLevel + 1];
+    Node *succs[Node::MaxLevel + 1];
+    if (!Find(item, preds, succs))
+      return false;
+    return Remove(succs[0], preds, succs);
   }
 
   bool Poll(ItemType &item) {
+    Guard guard(reclaimer);
     Node *node = GetAndMarkFirst();
     if (node) {
+      Node *preds[Node::MaxLevel + 1];
+      Node *succs[Node::MaxLevel + 1];
       item = node->item;
-      Erase(node->item);
+      Remove(node, preds, succs);
       return true;
     } else {
       return false;
@@ -80,8 +86,9 @@ using Node = SkipListNode<ItemType>;
   }
 
   bool Contains(const ItemType &item) {
+    Guard guard(reclaimer);
     bool mark = false;
-    Node *pred = head, *curr = nullptr, *succ = nullptr;
+    Node *pred = head.get(), *curr = nullptr, *succ = nullptr;
     for (uint32_t level = Node::MaxLevel; level != UINT32_MAX; --level) {
       curr = pred->next[level].Get();
       while (true) {
@@ -102,19 +109,22 @@ using Node = SkipListNode<ItemType>;
   }
 
  private:
-  Node *head;
-  Node *tail;
+  Reclaimer &reclaimer;
+  std::unique_ptr<Node> head;
+  std::unique_ptr<Node> tail;
   std::mt19937 rand_gen;
   std::uniform_int_distribution<uint32_t> dist;
 
+  /// With past_equal the search goes on past the nodes equal to item, and so snips every marked one among them
   bool Find(const ItemType &item,
-            std::vector<Node *> &preds,
-            std::vector<Node *> &succs) {
+            Node **preds,
+            Node **succs,
+            bool past_equal = false) {
     bool mark = false;
     Node *pred = nullptr, *curr = nullptr, *succ = nullptr;
     while (true) {
       bool retry = false;
-      pred = head;
+      pred = head.get();
       for (uint32_t level = Node::MaxLevel; level != UINT32_MAX; --level) {
         curr = pred->next[level].Get();
         while (true) {
@@ -128,7 +138,7 @@ using Node = SkipListNode<ItemType>;
             curr = pred->next[level].Get();
             succ = curr->next[level].Get(mark);
           }
-          if (!retry && curr->item < item) {
+          if (!retry && (curr->item < item || (past_equal && curr != tail.get() && !(item < curr->item)))) {
             pred = curr;
             curr = succ;
           } else {
@@ -144,6 +154,57 @@ using Node = SkipListNode<ItemType>;
     }
   }
 
+  /// Link an inserted node on an upper level, unless it is being removed
+  bool LinkLevel(Node *node,
+                 uint32_t level,
+                 Node **preds,
+                 Node **succs) {
+    while (true) {
+      bool mark = false;
+      Node *succ = node->next[level].Get(mark);
+      if (mark)
+        return false;
+      // the successor found when linking the lower levels may have been removed since
+      if (succ != succs[level] && !node->next[level].CompareAndSet(succ, succs[level], false, false))
+        continue;
+      if (preds[level]->next[level].CompareAndSet(succs[level], node, false, false))
+        return true;
+      Find(node->item, preds, succs);
+    }
+  }
+
+  bool Remove(Node *node,
+              Node **preds,
+              Node **succs) {
+    for (uint32_t level = node->top_level; level != 0; --level) {
+      bool mark = false;
+      auto *succ = node->next[level].Get(mark);
+      while (!mark) {
+        node->next[level].CompareAndSet(succ, succ, false, true);
+        succ = node->next[level].Get(mark);
+      }
+    }
+    bool mark = false;
+    auto *succ = node->next[0].Get(mark);
+    while (true) {
+      bool i_am_the_marker = node->next[0].CompareAndSet(succ, succ, false, true);
+      succ = node->next[0].Get(mark);
+      if (i_am_the_marker) {
+        Find(node->item, preds, succs, true);
+        Release(node);
+        return true;
+      } else if (mark) {
+        return false;
+      }
+    }
+  }
+
+  /// Called by the insert and by the removal once each is done linking or unlinking the node
+  void Release(Node *node) {
+    if (node->num_refs.fetch_sub(1) == 1)
+      reclaimer.Retire(node);
+  }
+
   uint32_t RandomLevel() {
     uint32_t level = 0;
     while (level < Node::MaxLevel) {
@@ -155,7 +216,7 @@ using Node = SkipListNode<ItemType>;
 
   Node *GetAndMarkFirst() {
     Node *curr = head->next[0].Get();
-    while (curr != tail)
+    while (curr != tail.get())
       if (!curr->marked) {
         bool mark = false;
         if (curr->marked.compare_exchange_strong(mark, true, std::memory_order_seq_cst, std::memory_order_seq_cst))
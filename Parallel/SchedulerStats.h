@@ -0,0 +1,152 @@
+
+#ifndef DECISIONTREE_SCHEDULERSTATS_H
+#define DECISIONTREE_SCHEDULERSTATS_H
+
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include "Job.h"
+
+/// Where the workers of a build spent their time, see SingleTreeBuildDriver::Stats.
+/// Each worker counts into its own copy, the copies are merged when the build is over.
+struct SchedulerStats {
+  /// Durations are counted in buckets, four to each power of 2 nanoseconds, so percentiles are within 19%
+  static const uint32_t NumSubBuckets = 4;
+  static const uint32_t NumBuckets = 64 * NumSubBuckets;
+  static const uint32_t NumJobTypes = Job::SetupRoot + 1;
+
+  /// Jobs of one type. MakeLeaf, FindSplitOnAllFeatures and WriteToTree run inside the job that calls them,
+  /// they are counted both on their own and as part of that job, and never wait in the queue.
+  struct JobStats {
+    uint64_t count;
+    uint64_t total_nanoseconds;
+    uint64_t total_wait_nanoseconds;
+    uint64_t buckets[NumBuckets];
+
+    JobStats():
+      count(0), total_nanoseconds(0), total_wait_nanoseconds(0), buckets() {}
+
+    void Add(uint64_t nanoseconds) {
+      ++count;
+      total_nanoseconds += nanoseconds;
+      ++buckets[Bucket(nanoseconds)];
+    }
+
+    void Merge(const JobStats &stats) {
+      count += stats.count;
+      total_nanoseconds += stats.total_nanoseconds;
+      total_wait_nanoseconds += stats.total_wait_nanoseconds;
+      for (uint32_t idx = 0; idx != NumBuckets; ++idx)
+        buckets[idx] += stats.buckets[idx];
+    }
+
+    /// Duration in seconds that a share of the jobs do not exceed, share from 0 to 1
+    double Percentile(double share) const {
+      uint64_t rank = static_cast<uint64_t>(share * count), num_below = 0;
+      for (uint32_t idx = 0; idx != NumBuckets; ++idx) {
+        num_below += buckets[idx];
+        if (num_below > rank || (num_below == count && count != 0))
+          return 1e-9 * BucketMiddle(idx);
+      }
+      return 0.0;
+    }
+  };
+
+  struct WorkerStats {
+    uint64_t num_jobs;
+    uint64_t num_steals;
+    uint64_t num_lane_polls;
+    double spin_time;
+    double parked_time;
+
+    WorkerStats():
+      num_jobs(0), num_steals(0), num_lane_polls(0), spin_time(0.0), parked_time(0.0) {}
+  };
+
+  /// Indexed by job type
+  JobStats job_stats[NumJobTypes];
+  std::vector<WorkerStats> worker_stats;
+  /// Jobs waiting in the whole queue, sampled by each worker every NumJobsPerQueueDepthSample jobs
+  vec_uint32_t queue_depths;
+  double build_time;
+
+  SchedulerStats():
+    job_stats(), worker_stats(), queue_depths(), build_time(0.0) {}
+
+  static uint64_t Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  /// Worker stats are merged by worker index
+  void Merge(const SchedulerStats &stats) {
+    for (uint32_t type = 0; type != NumJobTypes; ++type)
+      job_stats[type].Merge(stats.job_stats[type]);
+    if (worker_stats.size() < stats.worker_stats.size())
+      worker_stats.resize(stats.worker_stats.size());
+    for (uint32_t worker_idx = 0; worker_idx != stats.worker_stats.size(); ++worker_idx) {
+      const WorkerStats &from = stats.worker_stats[worker_idx];
+      WorkerStats &to = worker_stats[worker_idx];
+      to.num_jobs += from.num_jobs;
+      to.num_steals += from.num_steals;
+      to.num_lane_polls += from.num_lane_polls;
+      to.spin_time += from.spin_time;
+      to.parked_time += from.parked_time;
+    }
+    queue_depths.insert(queue_depths.end(), stats.queue_depths.begin(), stats.queue_depths.end());
+    build_time += stats.build_time;
+  }
+
+  void WriteJson(std::ostream &out) const {
+    out << "{\"build_time\": " << build_time << ", \"jobs\": {";
+    bool first = true;
+    for (uint32_t type = 0; type != NumJobTypes; ++type) {
+      const JobStats &stats = job_stats[type];
+      if (stats.count == 0)
+        continue;
+      out << (first? "" : ", ") << "\"" << JobTypeName(type) << "\": {\"count\": " << stats.count
+          << ", \"total_time\": " << 1e-9 * stats.total_nanoseconds
+          << ", \"wait_time\": " << 1e-9 * stats.total_wait_nanoseconds
+          << ", \"p50\": " << stats.Percentile(0.5) << ", \"p90\": " << stats.Percentile(0.9)
+          << ", \"p99\": " << stats.Percentile(0.99) << "}";
+      first = false;
+    }
+    out << "}, \"workers\": [";
+    for (uint32_t worker_idx = 0; worker_idx != worker_stats.size(); ++worker_idx) {
+      const WorkerStats &stats = worker_stats[worker_idx];
+      out << (worker_idx == 0? "" : ", ") << "{\"jobs\": " << stats.num_jobs << ", \"steals\": " << stats.num_steals
+          << ", \"lane_polls\": " << stats.num_lane_polls << ", \"spin_time\": " << stats.spin_time
+          << ", \"parked_time\": " << stats.parked_time << "}";
+    }
+    out << "], \"queue_depths\": [";
+    for (uint32_t idx = 0; idx != queue_depths.size(); ++idx)
+      out << (idx == 0? "" : ", ") << queue_depths[idx];
+    out << "]}";
+  }
+
+  static const char *JobTypeName(uint32_t type) {
+    static const char *names[NumJobTypes] = {"", "WriteToTree", "MakeLeaf", "FindSplitOnBinRange",
+                                             "FindSplitOnOneFeature", "FindSplitOnAllFeatures", "DoSplit",
+                                             "InitSplit", "SetupRoot"};
+    return names[type];
+  }
+
+ private:
+  static uint32_t Bucket(uint64_t nanoseconds) {
+    if (nanoseconds < NumSubBuckets)
+      return static_cast<uint32_t>(nanoseconds);
+    auto msb = static_cast<uint32_t>(63 - __builtin_clzll(nanoseconds));
+    return msb * NumSubBuckets + static_cast<uint32_t>((nanoseconds >> (msb - 2)) & (NumSubBuckets - 1));
+  }
+
+  static double BucketMiddle(uint32_t bucket) {
+    if (bucket < 2 * NumSubBuckets)
+      return bucket;
+    uint32_t msb = bucket / NumSubBuckets;
+    double width = static_cast<double>(1ull << (msb - 2));
+    return (NumSubBuckets + bucket % NumSubBuckets) * width + width / 2;
+  }
+};
+
+#endif
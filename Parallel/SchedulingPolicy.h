@@ -0,0 +1,113 @@
+
+#ifndef DECISIONTREE_SCHEDULINGPOLICY_H
+#define DECISIONTREE_SCHEDULINGPOLICY_H
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "../Global/GlobalConsts.h"
+#include "../Tree/TreeParams.h"
+#include "../Tree/TreeNode.h"
+#include "Job.h"
+
+/// Decides which jobs of a build go to the priority lane of the job queue, ordered against the jobs of all workers,
+/// and how they are ranked there. Lane jobs run by priority, highest first, then in Job order.
+/// Any other job stays in the deque of the worker that made it.
+class SchedulingPolicy {
+ public:
+  explicit SchedulingPolicy(const TreeParams &params):
+    params(params) {}
+
+  virtual ~SchedulingPolicy() = default;
+
+  /// With a node budget, splits are taken best gain first across all workers
+  bool ToLane(const Job &job) const {
+    return !job.node || job.node->Size() >= MinSizeForLane() || (job.type == Job::DoSplit && LimitsNumNodes());
+  }
+
+  /// A node budget keeps the order by job type and gain, which decides the nodes split within the budget
+  uint64_t Priority(const Job &job) const {
+    return (!job.node || LimitsNumNodes())? 0 : NodePriority(job.node);
+  }
+
+ protected:
+  const TreeParams params;
+
+  virtual uint32_t MinSizeForLane() const = 0;
+  virtual uint64_t NodePriority(const TreeNode *node) const = 0;
+
+  bool LimitsNumNodes() const {
+    return params.max_num_nodes != UINT32_MAX;
+  }
+};
+
+/// Jobs stay with the worker that made them unless their node is very large, lane jobs go by job type
+class LocalFirstPolicy: public SchedulingPolicy {
+ public:
+  explicit LocalFirstPolicy(const TreeParams &params):
+    SchedulingPolicy::SchedulingPolicy(params) {}
+
+ protected:
+  uint32_t MinSizeForLane() const override {
+    return MinSizeForPriorityLane;
+  }
+
+  uint64_t NodePriority(const TreeNode *) const override {
+    return 0;
+  }
+};
+
+/// The jobs of the largest nodes run first, so that a large subtree does not start last and set the makespan
+class LargestSubsetFirstPolicy: public SchedulingPolicy {
+ public:
+  explicit LargestSubsetFirstPolicy(const TreeParams &params):
+    SchedulingPolicy::SchedulingPolicy(params) {}
+
+ protected:
+  uint32_t MinSizeForLane() const override {
+    return MinSizeForOrderedLane;
+  }
+
+  uint64_t NodePriority(const TreeNode *node) const override {
+    return node->Size();
+  }
+};
+
+/// The jobs of the nodes with the most work left under them run first. A level of a subtree scans about as many
+/// samples as the node holds, and a subtree of n samples has about log2(n / min_split_node) levels, no more than
+/// max_depth allows below the node.
+class EstimatedWorkFirstPolicy: public SchedulingPolicy {
+ public:
+  explicit EstimatedWorkFirstPolicy(const TreeParams &params):
+    SchedulingPolicy::SchedulingPolicy(params) {}
+
+ protected:
+  uint32_t MinSizeForLane() const override {
+    return MinSizeForOrderedLane;
+  }
+
+  uint64_t NodePriority(const TreeNode *node) const override {
+    double size = node->Size();
+    double num_levels = std::log2(std::max(1.0, size / std::max(params.min_split_node, 1u)));
+    if (params.max_depth != UINT32_MAX) {
+      uint32_t num_levels_left = params.max_depth - std::min(node->Depth(), params.max_depth);
+      num_levels = std::min(num_levels, static_cast<double>(num_levels_left));
+    }
+    return static_cast<uint64_t>(size * (1.0 + num_levels));
+  }
+};
+
+inline std::unique_ptr<SchedulingPolicy> MakeSchedulingPolicy(uint32_t policy_id,
+                                                              const TreeParams &params) {
+  switch (policy_id) {
+    case LargestSubsetFirst:
+      return std::make_unique<LargestSubsetFirstPolicy>(params);
+    case EstimatedWorkFirst:
+      return std::make_unique<EstimatedWorkFirstPolicy>(params);
+    default:
+      return std::make_unique<LocalFirstPolicy>(params);
+  }
+}
+
+#endif
@@ -4,46 +4,36 @@
 
 #include <cstdint>
 #include <atomic>
-#include <memory>
-#include <deque>
-#include <vector>
 #include "AtomicMarkablePtr.h"
 
 template <typename ItemType>
 struct SkipListNode {
  public:
-  static SkipListNode *GetHead() {
-    static thread_local std::deque<std::unique_ptr<SkipListNode>> nodes;
-    nodes.emplace_back(new SkipListNode(ItemType::Min(), MaxLevel));
-    return nodes.back().get();
-  }
-
-  static SkipListNode *GetTail() {
-    static thread_local std::deque<std::unique_ptr<SkipListNode>> nodes;
-    nodes.emplace_back(new SkipListNode(ItemType::Max(), MaxLevel));
-    return nodes.back().get();
-  }
-
-  static SkipListNode *GetNode(const ItemType &item,
-                               uint32_t level) {
-    static thread_local std::deque<std::unique_ptr<SkipListNode>> nodes;
-    nodes.emplace_back(new SkipListNode(item, level));
-    return nodes.back().get();
-  }
-
   static const uint32_t MaxLevel = 7;
   static const uint32_t InverseProb = 4;
+  /// The insert and the removal of the node each hold a reference, see LockFreeSkipList::Release
+  static const uint32_t NumRefs = 2;
 
-  const uint32_t top_level;
-  const ItemType item;
+  uint32_t top_level;
+  ItemType item;
   std::atomic<bool> marked;
-  std::vector<AtomicMarkablePtr<SkipListNode>> next;
+  std::atomic<uint32_t> num_refs;
+  /// Every node has room for all levels, so that recycled nodes fit any level
+  AtomicMarkablePtr<SkipListNode> next[MaxLevel + 1];
 
- private:
   SkipListNode(const ItemType &item,
                const uint32_t level):
-    top_level(level), item(item), marked(false), next(level + 1) {}
+    top_level(level), item(item), marked(false), num_refs(NumRefs), next() {}
+
+  void Reset(const ItemType &item,
+             const uint32_t level) {
+    this->top_level = level;
+    this->item = item;
+    marked = false;
+    num_refs = NumRefs;
+    for (auto &ptr: next)
+      ptr.Set(nullptr, false);
+  }
 };
 
-
 #endif
@@ -0,0 +1,119 @@
+
+#ifndef DECISIONTREE_THREADPOOL_H
+#define DECISIONTREE_THREADPOOL_H
+
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../Util/Numa.h"
+
+/// Threads of the process, started once and kept for every tree build and prediction.
+/// Work comes in groups of tasks, the thread that submits a group takes part in it and returns once all of its tasks
+/// are done. So a group always completes, even when every pool thread is busy with other groups,
+/// and a task may itself submit a group.
+class ThreadPool {
+ public:
+  static ThreadPool &GetInstance() {
+    static ThreadPool instance;
+    return instance;
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mut);
+      stop = true;
+    }
+    cv_work.notify_all();
+    for (auto &thread: threads)
+      thread.join();
+  }
+
+  /// Start threads until there are num_threads, the pool never shrinks.
+  /// Once asked to pin, the pool binds each of its threads, then and later, to one CPU, spread over the NUMA nodes.
+  void Reserve(uint32_t num_threads,
+               bool pin_threads = false) {
+    std::lock_guard<std::mutex> lock(mut);
+    while (threads.size() < num_threads)
+      threads.emplace_back(&ThreadPool::Work, this);
+    this->pin_threads = this->pin_threads || pin_threads;
+    for (; this->pin_threads && num_pinned != threads.size(); ++num_pinned)
+      Numa::PinToCpu(threads[num_pinned], Numa::SpreadCpu(num_pinned));
+  }
+
+  uint32_t NumThreads() {
+    std::lock_guard<std::mutex> lock(mut);
+    return static_cast<uint32_t>(threads.size());
+  }
+
+  /// Run task(0), ..., task(num_tasks - 1) and wait for all of them,
+  /// the pool grows so that all tasks can run at the same time
+  void Run(uint32_t num_tasks,
+           const std::function<void(uint32_t)> &task) {
+    if (num_tasks == 0)
+      return;
+    Reserve(num_tasks - 1);
+    Group group(task, num_tasks);
+    std::unique_lock<std::mutex> lock(mut);
+    groups.push_back(&group);
+    cv_work.notify_all();
+    while (group.next_idx != num_tasks)
+      RunOne(lock, &group);
+    while (group.num_done != num_tasks)
+      cv_done.wait(lock);
+  }
+
+ private:
+  struct Group {
+    const std::function<void(uint32_t)> &task;
+    const uint32_t num_tasks;
+    uint32_t next_idx;
+    uint32_t num_done;
+
+    Group(const std::function<void(uint32_t)> &task,
+          uint32_t num_tasks):
+      task(task), num_tasks(num_tasks), next_idx(0), num_done(0) {}
+  };
+
+  std::mutex mut;
+  std::condition_variable cv_work;
+  std::condition_variable cv_done;
+  std::deque<Group *> groups;
+  std::vector<std::thread> threads;
+  bool pin_threads;
+  uint32_t num_pinned;
+  bool stop;
+
+  ThreadPool():
+    mut(), cv_work(), cv_done(), groups(), threads(), pin_threads(false), num_pinned(0), stop(false) {}
+
+  void Work() {
+    std::unique_lock<std::mutex> lock(mut);
+    while (true) {
+      while (!stop && groups.empty())
+        cv_work.wait(lock);
+      if (stop)
+        return;
+      RunOne(lock, groups.front());
+    }
+  }
+
+  /// Claim the next task of a group, run it unlocked
+  void RunOne(std::unique_lock<std::mutex> &lock,
+              Group *group) {
+    uint32_t task_idx = group->next_idx++;
+    if (group->next_idx == group->num_tasks)
+      groups.erase(std::find(groups.begin(), groups.end(), group));
+    lock.unlock();
+    group->task(task_idx);
+    lock.lock();
+    if (++group->num_done == group->num_tasks)
+      cv_done.notify_all();
+  }
+};
+
+#endif
@@ -0,0 +1,146 @@
+
+#ifndef DECISIONTREE_WORKSTEALINGDEQUE_H
+#define DECISIONTREE_WORKSTEALINGDEQUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/// Chase-Lev work stealing deque, with the memory orders of Le, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+/// The owning worker pushes and pops at the bottom, any other worker steals from the top.
+/// Items are copied in and out word by word through atomics, a thief may read a slot the owner is overwriting
+/// and then throws the copy away when it loses the race on top.
+template <typename ItemType>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(uint32_t log_capacity = InitialLogCapacity):
+    top(0), padding(), bottom(0), buffer(nullptr), buffers() {
+    buffers.emplace_back(new Buffer(log_capacity));
+    buffer = buffers.back().get();
+  }
+
+  /// Owner only
+  void Push(const ItemType &item) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(a->Capacity()) - 1)
+      a = Grow(a, t, b);
+    a->Put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Owner only, takes the item pushed last
+  bool Pop(ItemType &item) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    a->Get(b, item);
+    if (t != b)
+      return true;
+    // last item, race the thieves for it
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  /// Any thread, takes the item pushed first. Fails when empty or when another thread took the item first.
+  bool Steal(ItemType &item) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+      return false;
+    Buffer *a = buffer.load(std::memory_order_acquire);
+    a->Get(t, item);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  /// Items in the deque at some point during the call
+  uint32_t Size() const {
+    int64_t t = top.load(std::memory_order_acquire);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    return (b > t)? static_cast<uint32_t>(b - t) : 0;
+  }
+
+  bool Empty() const {
+    int64_t t = top.load(std::memory_order_acquire);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    return t >= b;
+  }
+
+ private:
+  static const uint32_t InitialLogCapacity = 8;
+  static const uint32_t CacheLineSize = 64;
+
+  class Buffer {
+   public:
+    explicit Buffer(uint32_t log_capacity):
+      log_capacity(log_capacity), mask((1ull << log_capacity) - 1),
+      words(new std::atomic<uint64_t>[(mask + 1) * NumWords]) {}
+
+    uint64_t Capacity() const {
+      return mask + 1;
+    }
+
+    void Put(int64_t idx,
+             const ItemType &item) {
+      uint64_t local_copy[NumWords];
+      memcpy(local_copy, &item, sizeof(ItemType));
+      std::atomic<uint64_t> *slot = words.get() + (idx & mask) * NumWords;
+      for (uint32_t word = 0; word != NumWords; ++word)
+        slot[word].store(local_copy[word], std::memory_order_relaxed);
+    }
+
+    void Get(int64_t idx,
+             ItemType &item) const {
+      uint64_t local_copy[NumWords];
+      const std::atomic<uint64_t> *slot = words.get() + (idx & mask) * NumWords;
+      for (uint32_t word = 0; word != NumWords; ++word)
+        local_copy[word] = slot[word].load(std::memory_order_relaxed);
+      memcpy(static_cast<void *>(&item), local_copy, sizeof(ItemType));
+    }
+
+    const uint32_t log_capacity;
+
+   private:
+    static_assert(sizeof(ItemType) % sizeof(uint64_t) == 0, "items are copied in whole 64 bit words");
+    static const uint32_t NumWords = sizeof(ItemType) / sizeof(uint64_t);
+
+    const uint64_t mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+  };
+
+  std::atomic<int64_t> top;
+  /// Keeps bottom, written by the owner on every push and pop, off the cache line of top
+  char padding[CacheLineSize - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom;
+  std::atomic<Buffer *> buffer;
+  /// Outgrown buffers are kept until the deque is destroyed, thieves may still be reading them
+  std::vector<std::unique_ptr<Buffer>> buffers;
+
+  Buffer *Grow(Buffer *a,
+               int64_t t,
+               int64_t b) {
+    buffers.emplace_back(new Buffer(a->log_capacity + 1));
+    Buffer *grown = buffers.back().get();
+    ItemType item = ItemType::Min();
+    for (int64_t idx = t; idx != b; ++idx) {
+      a->Get(idx, item);
+      grown->Put(idx, item);
+    }
+    buffer.store(grown, std::memory_order_release);
+    return grown;
+  }
+};
+
+#endif
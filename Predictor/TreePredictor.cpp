@@ -1,10 +1,12 @@
 
+#include <algorithm>
 #include "TreePredictor.h"
 #include "../Tree/StoredTree.h"
 #include "../Dataset/Dataset.h"
+#include "../Util/Numa.h"
 
 TreePredictor::TreePredictor() :
-  class_tree(nullptr), regress_tree(nullptr) {}
+  class_tree(nullptr), regress_tree(nullptr), sample_weights(nullptr) {}
 
 TreePredictor::~TreePredictor() = default;
 
@@ -16,25 +18,31 @@ void TreePredictor::BindToTree(const RegressionStoredTree &tree) {
   regress_tree = &tree;
 }
 
+void TreePredictor::LoadSampleWeights(const vec_uint8_t *sample_weights) {
+  this->sample_weights = sample_weights;
+}
+
 double TreePredictor::PredictOneByMean(const Dataset *dataset,
                                        uint32_t sample_id) {
   if (regress_tree->num_cell == 0)
     return regress_tree->leaf_mean[0];
+  uint32_t node = Numa::ThreadNode();
   int32_t cell_id = 0;
   do {
-    cell_id = NextNode(regress_tree, dataset, cell_id, sample_id);
+    cell_id = NextNode(regress_tree, dataset, node, cell_id, sample_id);
   } while (cell_id > 0);
   int32_t leaf_id = -cell_id;
   return regress_tree->leaf_mean[leaf_id];
 }
 
-vec_dbl_t TreePredictor::PredictOneByProbability(const Dataset *dataset,
-                                                 uint32_t sample_id) {
+const vec_dbl_t &TreePredictor::PredictOneByProbability(const Dataset *dataset,
+                                                        uint32_t sample_id) {
   if (class_tree->num_cell == 0)
     return class_tree->leaf_probability[0];
+  uint32_t node = Numa::ThreadNode();
   int32_t cell_id = 0;
   do {
-    cell_id = NextNode(class_tree, dataset, cell_id, sample_id);
+    cell_id = NextNode(class_tree, dataset, node, cell_id, sample_id);
   } while (cell_id > 0);
   int32_t leaf_id = -cell_id;
   return class_tree->leaf_probability[leaf_id];
@@ -43,33 +51,39 @@ vec_dbl_t TreePredictor::PredictOneByProbability(const Dataset *dataset,
 vec_dbl_t TreePredictor::PredictBatchByMean(const Dataset *dataset,
                                             const uint32_t filter) {
   vec_dbl_t predictions(dataset->Meta().size, 0.0);
-  const vec_uint32_t &sample_weights = dataset->SampleWeights();
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx)
-    if (ToPredict(sample_weights, idx, filter))
+    if (ToPredict(dataset, idx, filter))
       predictions[idx] = PredictOneByMean(dataset, idx);
   return predictions;
 }
 
-vec_vec_dbl_t TreePredictor::PredictBatchByProbability(const Dataset *dataset,
-                                                       const uint32_t filter) {
-  vec_vec_dbl_t predictions(dataset->Meta().size);
-  const vec_uint32_t &sample_weights = dataset->SampleWeights();
+void TreePredictor::PredictBatchByProbability(const Dataset *dataset,
+                                              prob_t *output,
+                                              const uint32_t filter) {
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx)
-    if (ToPredict(sample_weights, idx, filter))
-      predictions[idx] = PredictOneByProbability(dataset, idx);
-  return predictions;
+    if (ToPredict(dataset, idx, filter))
+      PredictRowByProbability(dataset, idx, output);
+}
+
+void TreePredictor::PredictRowByProbability(const Dataset *dataset,
+                                            uint32_t idx,
+                                            prob_t *output) {
+  const vec_dbl_t &probability = PredictOneByProbability(dataset, idx);
+  std::copy(probability.begin(), probability.end(), output + static_cast<size_t>(idx) * probability.size());
 }
 
-bool TreePredictor::ToPredict(const vec_uint32_t &sample_weights,
+bool TreePredictor::ToPredict(const Dataset *dataset,
                               const uint32_t idx,
                               const uint32_t filter) {
-  return filter == PredictAll ||
-         (sample_weights[idx] > 0 && filter == PredictPresent) ||
-         (sample_weights[idx] == 0 && filter == PredictAbsent);
+  if (filter == PredictAll)
+    return true;
+  bool present = sample_weights? (*sample_weights)[idx] > 0 : dataset->SampleWeights()[idx] > 0;
+  return present == (filter == PredictPresent);
 }
 
 int32_t TreePredictor::NextNode(const StoredTree *tree,
                                 const Dataset *dataset,
+                                uint32_t node,
                                 int32_t cell_id,
                                 uint32_t sample_id) {
   uint32_t cell_type = tree->cell_type[cell_id];
@@ -80,7 +94,7 @@ int32_t TreePredictor::NextNode(const StoredTree *tree,
   int32_t left_id = tree->left[cell_id];
   int32_t right_id = tree->right[cell_id];
 
-  const generic_vec_t &features = dataset->Features(feature_idx);
+  const generic_vec_t &features = dataset->Features(feature_idx, node);
   switch (feature_type) {
     case IsContinuous:
       return (Generics::RoundAt<float>(features, sample_id) < info.float_point) ? left_id : right_id;
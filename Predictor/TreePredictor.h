@@ -27,13 +27,16 @@ class TreePredictor {
   /// Bind to Regression Tree
   void BindToTree(const RegressionStoredTree &tree);
 
+  /// Weights the filters go by, those a tree was trained on. nullptr for the weights of the dataset.
+  void LoadSampleWeights(const vec_uint8_t *sample_weights);
+
   /// Predict one sample in a dataset by mean label value in regression task
   double PredictOneByMean(const Dataset *dataset,
                           uint32_t sample_id);
 
-  /// Predict one sample in a dataset by probability in classification task
-  vec_dbl_t PredictOneByProbability(const Dataset *dataset,
-                                    uint32_t sample_id);
+  /// Predict one sample in a dataset by probability in classification task, the probabilities of its leaf
+  const vec_dbl_t &PredictOneByProbability(const Dataset *dataset,
+                                           uint32_t sample_id);
 
   /// Predict samples in a dataset by mean value in regression task
   /// filter == PredictAll: predict all samples
@@ -42,22 +45,31 @@ class TreePredictor {
   virtual vec_dbl_t PredictBatchByMean(const Dataset *dataset,
                                        const uint32_t filter = PredictAll);
 
-  /// Predict samples in a dataset by probability in classification task
+  /// Predict samples in a dataset by probability in classification task, into the flat N x C buffer at output,
+  /// the rows of samples not predicted are left as they are
   /// filter == PredictAll: predict all samples
   /// filter == PredictPresent: predict samples whose weight are nonzero
   /// filter == PredictAbsent: predict samples whose weight are zero
-  virtual vec_vec_dbl_t PredictBatchByProbability(const Dataset *dataset,
-                                                  const uint32_t filter = PredictAll);
+  virtual void PredictBatchByProbability(const Dataset *dataset,
+                                         prob_t *output,
+                                         const uint32_t filter = PredictAll);
 
  protected:
   const ClassificationStoredTree *class_tree;
   const RegressionStoredTree *regress_tree;
+  const vec_uint8_t *sample_weights;
 
-  bool ToPredict(const vec_uint32_t &sample_weights,
+  /// Write the probabilities of sample idx to its row of output
+  void PredictRowByProbability(const Dataset *dataset,
+                               uint32_t idx,
+                               prob_t *output);
+  bool ToPredict(const Dataset *dataset,
                  const uint32_t idx,
                  const uint32_t selection);
+  /// node is the NUMA node of the calling thread, looked up once per sample
   int32_t NextNode(const StoredTree *tree,
                    const Dataset *dataset,
+                   uint32_t node,
                    int32_t cell_id,
                    uint32_t sample_id);
 };
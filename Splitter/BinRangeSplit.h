@@ -0,0 +1,72 @@
+
+#ifndef DECISIONTREE_BINRANGESPLIT_H
+#define DECISIONTREE_BINRANGESPLIT_H
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include "../Generics/TypeDefs.h"
+
+/// Brute force search of a many-vs-many feature split across jobs.
+/// The Gray code sequence of 2^(n-1) bin assignments is cut into consecutive ranges, one job each.
+/// The bin-class histogram is built once by the job that searched the feature and copied in by every range job,
+/// each range then records its best assignment in its own slot, and the last range to finish reduces the slots.
+class BinRangeSplit {
+ public:
+  BinRangeSplit(uint32_t num_bins,
+                uint32_t num_classes,
+                uint32_t num_ranges):
+    num_bins(num_bins), num_ranges(num_ranges), bin_ids(num_bins, 0), binwise_wnum_samples(num_bins, 0.0),
+    bin_class_matrix(num_bins * num_classes, 0.0), lowest_costs(num_ranges, 0.0), best_bitmasks(num_ranges, 0),
+    num_pending_ranges(num_ranges) {}
+
+  /// Number of non-empty bins, and number of ranges the search is cut into
+  const uint32_t num_bins;
+  const uint32_t num_ranges;
+
+  /// Bin ids, weighted number of samples of each bin and the bin-class matrix, all in order of bin_ids
+  vec_uint32_t bin_ids;
+  vec_dbl_t binwise_wnum_samples;
+  vec_dbl_t bin_class_matrix;
+
+  /// Best cost and the corresponding Gray code bitmask found by each range
+  vec_dbl_t lowest_costs;
+  vec_uint32_t best_bitmasks;
+
+  uint32_t NumFlips() const {
+    return 1u << (num_bins - 1);
+  }
+
+  /// First Gray code index enumerated by a range, index 0 is the initial all-left assignment and never evaluated
+  uint32_t RangeBegin(uint32_t range_idx) const {
+    uint32_t begin = range_idx * (NumFlips() / num_ranges);
+    return (begin == 0)? 1 : begin;
+  }
+
+  /// One past the last Gray code index enumerated by a range
+  uint32_t RangeEnd(uint32_t range_idx) const {
+    return (range_idx == num_ranges - 1)? NumFlips() : (range_idx + 1) * (NumFlips() / num_ranges);
+  }
+
+  /// Count down the pending ranges, return true to the caller that finishes the last one
+  bool FinishRange() {
+    return --num_pending_ranges == 0;
+  }
+
+  /// Best bitmask over all ranges.
+  /// A tie goes to the earlier range, which is the one the serial enumeration would have kept.
+  uint32_t Reduce(double &lowest_cost) const {
+    uint32_t best_bitmask = 0;
+    for (uint32_t range_idx = 0; range_idx != num_ranges; ++range_idx)
+      if (lowest_costs[range_idx] < lowest_cost) {
+        lowest_cost = lowest_costs[range_idx];
+        best_bitmask = best_bitmasks[range_idx];
+      }
+    return best_bitmask;
+  }
+
+ private:
+  std::atomic<uint32_t> num_pending_ranges;
+};
+
+#endif
@@ -3,6 +3,7 @@
 #define DECISIONTREE_CLASSIFICATIONSPLITMANIPULATOR_H
 
 #include <vector>
+#include <array>
 #include <cstdint>
 #include "../Dataset/Dataset.h"
 #include "../Tree/TreeParams.h"
@@ -10,6 +11,7 @@
 #include "../Util/Maths.h"
 #include "../Util/Random.h"
 #include "../Util/Cost.h"
+#include "BinRangeSplit.h"
 
 #define IS_INTEGRAL_FEATURE (std::is_integral<feature_t>::value)
 #define IS_INTEGRAL_LABEL (std::is_integral<label_t>::value)
@@ -20,13 +22,36 @@ using std::fill;
 using std::iota;
 using std::sort;
 
+/// Storage of a per-class histogram
+/// A std::array when the number of classes is known at compile time, so that loops over classes can be unrolled,
+/// or a heap allocated vector sized at runtime when NumClasses == 0
+template <typename class_weight_t, uint32_t NumClasses>
+struct ClassHistogram {
+  using type = std::array<class_weight_t, NumClasses>;
+  static type Make(uint32_t) {
+    type histogram;
+    histogram.fill(static_cast<class_weight_t>(0));
+    return histogram;
+  }
+};
+
 template <typename class_weight_t>
+struct ClassHistogram<class_weight_t, 0> {
+  using type = vector<class_weight_t>;
+  static type Make(uint32_t num_classes) {
+    return type(num_classes, static_cast<class_weight_t>(0));
+  }
+};
+
+template <typename class_weight_t, uint32_t NumClasses>
 class ClaStats {
+  using histogram_t = typename ClassHistogram<class_weight_t, NumClasses>::type;
+
  public:
-  vector<class_weight_t> init_left;
-  vector<class_weight_t> init_right;
-  vector<class_weight_t> cur_left;
-  vector<class_weight_t> cur_right;
+  histogram_t init_left;
+  histogram_t init_right;
+  histogram_t cur_left;
+  histogram_t cur_right;
   vector<class_weight_t> bin_class_matrix;
   vector<class_weight_t> binwise_wnum_samples;
   vec_uint32_t bin_ids;
@@ -46,23 +71,25 @@ class ClaStats {
   ClaStats(const MetaData &meta,
            const vec_dbl_t &class_weights,
            const TreeParams &params):
-    meta(meta), init_left(meta.num_classes, 0), init_right(meta.num_classes, 0), cur_left(meta.num_classes, 0),
-    cur_right(meta.num_classes, 0), bin_class_matrix(meta.max_num_bins * meta.num_classes, 0),
+    meta(meta), init_left(ClassHistogram<class_weight_t, NumClasses>::Make(meta.num_classes)),
+    init_right(ClassHistogram<class_weight_t, NumClasses>::Make(meta.num_classes)),
+    cur_left(ClassHistogram<class_weight_t, NumClasses>::Make(meta.num_classes)),
+    cur_right(ClassHistogram<class_weight_t, NumClasses>::Make(meta.num_classes)),
+    bin_class_matrix(meta.max_num_bins * meta.num_classes, 0),
     binwise_wnum_samples(meta.max_num_bins, 0), bin_ids(meta.max_num_bins, 0), fractions(meta.max_num_bins, 0.0),
     wnum_samples_left(0), wnum_samples_right(0), wnum_samples(0), num_bins(0), updater_left(0.0), updater_right(0.0),
-    class_weights((params.cost_function == GiniImpurity)?
-                  Maths::ScaleAndCast<class_weight_t>(class_weights, 1.0) :
-                  Maths::ScaleAndCast<class_weight_t>(class_weights, Cost::multiplier)),
-    effective_min_leaf_node((params.cost_function == GiniImpurity)?
-                            params.min_leaf_node :
-                            Generics::Round<class_weight_t, double>(params.min_leaf_node * Cost::multiplier)) {}
+    class_weights(class_weights),
+    effective_min_leaf_node(params.min_leaf_node) {}
 };
 
+/// Cost computers are agnostic to the storage of histograms, so that the same computer serves
+/// both the fixed-size and the dynamically-sized ClaStats
 class GiniCostComputer {
  public:
 
+  template <typename histogram_t>
   void Init(const NodeStats *node_stats,
-            vec_dbl_t &init_histo,
+            histogram_t &init_histo,
             double &init_wnum_samples,
             double &init_updater) {
     copy(node_stats->Histogram().begin(), node_stats->Histogram().end(), init_histo.begin());
@@ -70,8 +97,10 @@ class GiniCostComputer {
     init_updater = init_wnum_samples * node_stats->Cost();
   }
 
-  void UpdateCost(ClaStats<double> &stats,
+  template <typename stats_t>
+  void UpdateCost(stats_t &stats,
                   double weight,
+                  uint32_t,
                   double wnum_all_left,
                   double wnum_one_left,
                   double wnum_all_right,
@@ -82,61 +111,118 @@ class GiniCostComputer {
     cost = stats.updater_left / wnum_all_left + stats.updater_right / wnum_all_right;
   }
 
-  double ComputeCost(ClaStats<double> &stats,
-                     const vec_dbl_t &histo,
+  template <typename stats_t, typename histogram_t>
+  double ComputeCost(stats_t &stats,
+                     const histogram_t &histo,
                      double wnum_samples,
                      uint32_t begin,
                      uint32_t num_classes) {
-    double cost = 0.0;
+    double cost = StartCost(wnum_samples);
     for (uint32_t idx = begin; idx != begin + num_classes; ++idx)
-      cost += histo[idx] * (wnum_samples - histo[idx]);
-    cost /= wnum_samples;
-    return cost;
+      cost = AccumulateCost(cost, histo[idx], wnum_samples);
+    return FinishCost(cost, wnum_samples);
+  }
+
+  /// ComputeCost split into steps, so that costs of several candidates can be accumulated class by class
+  double StartCost(double) {
+    return 0.0;
+  }
+
+  double AccumulateCost(double cost,
+                        double height,
+                        double wnum_samples) {
+    return cost + height * (wnum_samples - height);
+  }
+
+  double FinishCost(double cost,
+                    double wnum_samples) {
+    return cost / wnum_samples;
   }
 };
 
+/// Entropy is computed directly on weighted counts, see Cost::NLogN
 class EntropyCostComputer {
  public:
+  template <typename histogram_t>
   void Init(const NodeStats *node_stats,
-            vec_uint32_t &init_histo,
-            uint32_t &init_wnum_samples,
+            histogram_t &init_histo,
+            double &init_wnum_samples,
             double &init_updater) {
-    for (uint32_t idx = 0; idx != node_stats->Histogram().size(); ++idx)
-      init_histo[idx] = Generics::Round<uint32_t, double>(Cost::multiplier * node_stats->Histogram()[idx]);
-    init_wnum_samples = Generics::Round<uint32_t, double>(Cost::multiplier * node_stats->WNumSamples());
+    copy(node_stats->Histogram().begin(), node_stats->Histogram().end(), init_histo.begin());
+    init_wnum_samples = node_stats->WNumSamples();
     init_updater = node_stats->Cost();
+    nlogn_left.resize(node_stats->Histogram().size());
+    for (uint32_t idx = 0; idx != nlogn_left.size(); ++idx)
+      nlogn_left[idx] = Cost::NLogN(init_histo[idx]);
+    nlogn_right.assign(nlogn_left.size(), 0.0);
+    nlogn_wnum_left = Cost::NLogN(init_wnum_samples);
+    nlogn_wnum_right = 0.0;
   }
 
-  void UpdateCost(ClaStats<uint32_t> &stats,
-                  uint32_t weight,
-                  uint32_t wnum_all_left,
-                  uint32_t wnum_one_left,
-                  uint32_t wnum_all_right,
-                  uint32_t wnum_one_right,
+  /// n log n of the counts before the move are kept from the previous call, only the new counts need a log
+  template <typename stats_t>
+  void UpdateCost(stats_t &stats,
+                  double,
+                  uint32_t label,
+                  double wnum_all_left,
+                  double wnum_one_left,
+                  double wnum_all_right,
+                  double wnum_one_right,
                   double &cost) {
-    stats.updater_left -= Cost::DeltaNLogN(wnum_all_left + weight, wnum_all_left) -
-                          Cost::DeltaNLogN(wnum_one_left + weight, wnum_one_left);
-    stats.updater_right += Cost::DeltaNLogN(wnum_all_right, wnum_all_right - weight) -
-                           Cost::DeltaNLogN(wnum_one_right, wnum_one_right - weight);
+    double nlogn_all_left = Cost::NLogN(wnum_all_left);
+    double nlogn_one_left = Cost::NLogN(wnum_one_left);
+    double nlogn_all_right = Cost::NLogN(wnum_all_right);
+    double nlogn_one_right = Cost::NLogN(wnum_one_right);
+    stats.updater_left -= (nlogn_wnum_left - nlogn_all_left) - (nlogn_left[label] - nlogn_one_left);
+    stats.updater_right += (nlogn_all_right - nlogn_wnum_right) - (nlogn_one_right - nlogn_right[label]);
+    nlogn_wnum_left = nlogn_all_left;
+    nlogn_left[label] = nlogn_one_left;
+    nlogn_wnum_right = nlogn_all_right;
+    nlogn_right[label] = nlogn_one_right;
     cost = stats.updater_left + stats.updater_right;
   }
 
-  double ComputeCost(ClaStats<uint32_t> &stats,
-                     const vector<uint32_t> &histo,
-                     uint32_t wnum_samples,
+  template <typename stats_t, typename histogram_t>
+  double ComputeCost(stats_t &stats,
+                     const histogram_t &histo,
+                     double wnum_samples,
                      uint32_t begin,
                      uint32_t num_classes) {
-    double cost = Cost::NLogN(wnum_samples);
+    double cost = StartCost(wnum_samples);
     for (uint32_t idx = begin; idx != begin + num_classes; ++idx)
-      cost -= Cost::NLogN(histo[idx]);
+      cost = AccumulateCost(cost, histo[idx], wnum_samples);
+    return FinishCost(cost, wnum_samples);
+  }
+
+  /// ComputeCost split into steps, so that costs of several candidates can be accumulated class by class
+  double StartCost(double wnum_samples) {
+    return Cost::NLogN(wnum_samples);
+  }
+
+  double AccumulateCost(double cost,
+                        double height,
+                        double) {
+    return cost - Cost::NLogN(height);
+  }
+
+  double FinishCost(double cost,
+                    double) {
     return cost;
   }
+
+ private:
+  vec_dbl_t nlogn_left;
+  vec_dbl_t nlogn_right;
+  double nlogn_wnum_left;
+  double nlogn_wnum_right;
 };
 
-template <typename CostComputer>
+/// NumClasses > 0 instantiates the manipulator for a fixed number of classes known at compile time
+/// NumClasses == 0 is the dynamic fallback, taking the number of classes from the dataset at runtime
+template <typename CostComputer, uint32_t NumClasses = 0>
 class ClaSplitManipulator {
 
-  using class_weight_t = std::conditional_t<std::is_same<CostComputer, GiniCostComputer>::value, double, uint32_t>;
+  using class_weight_t = double;
 
  public:
   explicit ClaSplitManipulator(const Dataset *dataset,
@@ -163,7 +249,7 @@ class ClaSplitManipulator {
     stats.cur_right[label] += weight;
     stats.wnum_samples_left -= weight;
     stats.wnum_samples_right += weight;
-    cost_computer.UpdateCost(stats, weight, stats.wnum_samples_left, stats.cur_left[label],
+    cost_computer.UpdateCost(stats, weight, label, stats.wnum_samples_left, stats.cur_left[label],
                              stats.wnum_samples_right, stats.cur_right[label], cost);
   }
 
@@ -174,7 +260,7 @@ class ClaSplitManipulator {
                const vec_uint32_t &sample_weights,
                uint32_t feature_idx,
                TreeNode *node) {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
 
     for (uint32_t idx = 0; idx != node->Size(); ++idx) {
       feature_t bin = features[idx];
@@ -193,16 +279,51 @@ class ClaSplitManipulator {
         stats.bin_ids[stats.num_bins++] = idx;
     }
 
-    cost_computer.Init(node->Stats(), stats.init_left, stats.wnum_samples, stats.updater_left);
-    copy(stats.init_left.begin(), stats.init_left.end(), stats.cur_left.begin());
-    fill(stats.init_right.begin(), stats.init_right.end(), static_cast<class_weight_t>(0));
-    fill(stats.cur_right.begin(), stats.cur_right.end(), static_cast<class_weight_t>(0));
-    stats.wnum_samples_left = stats.wnum_samples;
-    stats.wnum_samples_right = 0;
+    ResetSides(node);
+  }
+
+  /// Cost of giving every non-empty bin a child of its own.
+  /// The cost is concave, no split of the bins into two children costs less.
+  double LowestCostBound() {
+    const uint32_t num_classes = NumClassesOf();
+    double cost = 0.0;
+    for (uint32_t idx = 0; idx != stats.num_bins; ++idx) {
+      uint32_t bin = stats.bin_ids[idx];
+      cost += cost_computer.ComputeCost(stats, stats.bin_class_matrix, stats.binwise_wnum_samples[bin],
+                                        bin * num_classes, num_classes);
+    }
+    return cost;
+  }
+
+  /// Copy the non-empty bins and their bin-class histogram out, to be shared by parallel brute force jobs
+  void ExportBins(BinRangeSplit &range_split) {
+    const uint32_t num_classes = NumClassesOf();
+    for (uint32_t idx = 0; idx != stats.num_bins; ++idx) {
+      uint32_t bin = stats.bin_ids[idx];
+      range_split.bin_ids[idx] = bin;
+      range_split.binwise_wnum_samples[idx] = stats.binwise_wnum_samples[bin];
+      for (uint32_t label = 0; label != num_classes; ++label)
+        range_split.bin_class_matrix[idx * num_classes + label] = stats.bin_class_matrix[bin * num_classes + label];
+    }
+  }
+
+  /// Counterpart of ExportBins, restore the state DiscreteInit would have left without rescanning the samples
+  void ImportBins(const BinRangeSplit &range_split,
+                  const TreeNode *node) {
+    const uint32_t num_classes = NumClassesOf();
+    for (uint32_t idx = 0; idx != range_split.num_bins; ++idx) {
+      uint32_t bin = range_split.bin_ids[idx];
+      stats.bin_ids[idx] = bin;
+      stats.binwise_wnum_samples[bin] = range_split.binwise_wnum_samples[idx];
+      for (uint32_t label = 0; label != num_classes; ++label)
+        stats.bin_class_matrix[bin * num_classes + label] = range_split.bin_class_matrix[idx * num_classes + label];
+    }
+    stats.num_bins = range_split.num_bins;
+    ResetSides(node);
   }
 
   void Clear() {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
     for (uint32_t idx = 0; idx != stats.num_bins; ++idx) {
       uint32_t bin = stats.bin_ids[idx];
       stats.binwise_wnum_samples[bin] = 0;
@@ -216,12 +337,12 @@ class ClaSplitManipulator {
 
   void MoveOneBinLToR(uint32_t bin,
                       double &cost) {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
     uint32_t offset = bin * num_classes;
-    std::transform(stats.cur_left.begin(), stats.cur_left.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_left.begin(), std::minus<>());
-    std::transform(stats.cur_right.begin(), stats.cur_right.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_right.begin(), std::plus<>());
+    for (uint32_t label = 0; label != num_classes; ++label) {
+      stats.cur_left[label] -= stats.bin_class_matrix[offset + label];
+      stats.cur_right[label] += stats.bin_class_matrix[offset + label];
+    }
     stats.wnum_samples_left -= stats.binwise_wnum_samples[bin];
     stats.wnum_samples_right += stats.binwise_wnum_samples[bin];
 
@@ -231,12 +352,12 @@ class ClaSplitManipulator {
 
   void MoveOneBinRToL(uint32_t bin,
                       double &cost) {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
     uint32_t offset = bin * num_classes;
-    std::transform(stats.cur_left.begin(), stats.cur_left.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_left.begin(), std::plus<>());
-    std::transform(stats.cur_right.begin(), stats.cur_right.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_right.begin(), std::minus<>());
+    for (uint32_t label = 0; label != num_classes; ++label) {
+      stats.cur_left[label] += stats.bin_class_matrix[offset + label];
+      stats.cur_right[label] -= stats.bin_class_matrix[offset + label];
+    }
     stats.wnum_samples_left += stats.binwise_wnum_samples[bin];
     stats.wnum_samples_right -= stats.binwise_wnum_samples[bin];
 
@@ -246,10 +367,10 @@ class ClaSplitManipulator {
 
   void SetOneVsAll(uint32_t bin,
                    double &cost) {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
     uint32_t offset = bin * num_classes;
-    std::transform(stats.init_left.begin(), stats.init_left.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_left.begin(), std::minus<>());
+    for (uint32_t label = 0; label != num_classes; ++label)
+      stats.cur_left[label] = stats.init_left[label] - stats.bin_class_matrix[offset + label];
     stats.wnum_samples_left = stats.wnum_samples - stats.binwise_wnum_samples[bin];
     stats.wnum_samples_right = stats.binwise_wnum_samples[bin];
     cost = cost_computer.ComputeCost(stats, stats.cur_left, stats.wnum_samples_left, 0, num_classes) +
@@ -271,27 +392,45 @@ class ClaSplitManipulator {
          });
   }
 
-  void MoveOneBinOutOfPlace(uint32_t bin,
-                            double &cost) {
-    const uint32_t num_classes = stats.meta.num_classes;
-    uint32_t offset = num_classes * bin;
-    std::transform(stats.init_left.begin(), stats.init_left.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_left.begin(), std::minus<>());
-    std::transform(stats.init_right.begin(), stats.init_right.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.cur_right.begin(), std::plus<>());
-    class_weight_t wnum_samples_left_cur = stats.wnum_samples_left - stats.binwise_wnum_samples[bin];
-    class_weight_t wnum_samples_right_cur = stats.wnum_samples_right + stats.binwise_wnum_samples[bin];
-    cost = cost_computer.ComputeCost(stats, stats.cur_left, wnum_samples_left_cur, 0, num_classes) +
-           cost_computer.ComputeCost(stats, stats.cur_right, wnum_samples_right_cur, 0, num_classes);
+  /// Cost of moving each of the first num_candidates bins out of place, evaluated as one batch.
+  /// Classes are the outer loop and candidates the inner one, so that the inner loop runs over contiguous
+  /// accumulators and can be vectorised.
+  void MoveBinsOutOfPlace(uint32_t num_candidates,
+                          double *costs) {
+    const uint32_t num_classes = NumClassesOf();
+    std::array<class_weight_t, MaxNumBinsForSampling> wnum_samples_left_cur;
+    std::array<class_weight_t, MaxNumBinsForSampling> wnum_samples_right_cur;
+    std::array<double, MaxNumBinsForSampling> cost_left;
+    std::array<double, MaxNumBinsForSampling> cost_right;
+    std::array<uint32_t, MaxNumBinsForSampling> offsets;
+    for (uint32_t idx = 0; idx != num_candidates; ++idx) {
+      uint32_t bin = stats.bin_ids[idx];
+      offsets[idx] = num_classes * bin;
+      wnum_samples_left_cur[idx] = stats.wnum_samples_left - stats.binwise_wnum_samples[bin];
+      wnum_samples_right_cur[idx] = stats.wnum_samples_right + stats.binwise_wnum_samples[bin];
+      cost_left[idx] = cost_computer.StartCost(wnum_samples_left_cur[idx]);
+      cost_right[idx] = cost_computer.StartCost(wnum_samples_right_cur[idx]);
+    }
+    for (uint32_t label = 0; label != num_classes; ++label)
+      for (uint32_t idx = 0; idx != num_candidates; ++idx) {
+        class_weight_t moved = stats.bin_class_matrix[offsets[idx] + label];
+        cost_left[idx] = cost_computer.AccumulateCost(cost_left[idx], stats.init_left[label] - moved,
+                                                      wnum_samples_left_cur[idx]);
+        cost_right[idx] = cost_computer.AccumulateCost(cost_right[idx], stats.init_right[label] + moved,
+                                                       wnum_samples_right_cur[idx]);
+      }
+    for (uint32_t idx = 0; idx != num_candidates; ++idx)
+      costs[idx] = cost_computer.FinishCost(cost_left[idx], wnum_samples_left_cur[idx]) +
+                   cost_computer.FinishCost(cost_right[idx], wnum_samples_right_cur[idx]);
   }
 
   void MoveOneBinInPlace(uint32_t bin) {
-    const uint32_t num_classes = stats.meta.num_classes;
+    const uint32_t num_classes = NumClassesOf();
     uint32_t offset = num_classes * bin;
-    std::transform(stats.init_left.begin(), stats.init_left.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.init_left.begin(), std::minus<>());
-    std::transform(stats.init_right.begin(), stats.init_right.end(), stats.bin_class_matrix.begin() + offset,
-                   stats.init_right.begin(), std::plus<>());
+    for (uint32_t label = 0; label != num_classes; ++label) {
+      stats.init_left[label] -= stats.bin_class_matrix[offset + label];
+      stats.init_right[label] += stats.bin_class_matrix[offset + label];
+    }
     stats.wnum_samples_left -= stats.binwise_wnum_samples[bin];
     stats.wnum_samples_right += stats.binwise_wnum_samples[bin];
   }
@@ -336,8 +475,9 @@ class ClaSplitManipulator {
   }
 
   void ShuffleBinId(uint32_t n,
-                    uint32_t k) {
-    Random::PartialShuffle(n, k, stats.bin_ids);
+                    uint32_t k,
+                    Philox &generator) {
+    Random::PartialShuffle(n, k, stats.bin_ids, generator);
   }
 
   void SwitchWithLast(uint32_t idx,
@@ -348,11 +488,28 @@ class ClaSplitManipulator {
   }
 
  private:
-  ClaStats<class_weight_t> stats;
+  ClaStats<class_weight_t, NumClasses> stats;
   CostComputer cost_computer;
+
+  /// Put all samples of the node on the left
+  void ResetSides(const TreeNode *node) {
+    cost_computer.Init(node->Stats(), stats.init_left, stats.wnum_samples, stats.updater_left);
+    copy(stats.init_left.begin(), stats.init_left.end(), stats.cur_left.begin());
+    fill(stats.init_right.begin(), stats.init_right.end(), static_cast<class_weight_t>(0));
+    fill(stats.cur_right.begin(), stats.cur_right.end(), static_cast<class_weight_t>(0));
+    stats.wnum_samples_left = stats.wnum_samples;
+    stats.wnum_samples_right = 0;
+  }
+
+  /// Compile-time constant for the fixed-size instantiations, so that loops over classes are unrolled
+  uint32_t NumClassesOf() const {
+    return (NumClasses == 0)? stats.meta.num_classes : NumClasses;
+  }
 };
 
-using GiniSplitManipulator = ClaSplitManipulator<GiniCostComputer>;
-using EntropySplitManipulator = ClaSplitManipulator<EntropyCostComputer>;
+template <uint32_t NumClasses = 0>
+using GiniSplitManipulator = ClaSplitManipulator<GiniCostComputer, NumClasses>;
+template <uint32_t NumClasses = 0>
+using EntropySplitManipulator = ClaSplitManipulator<EntropyCostComputer, NumClasses>;
 
 #endif
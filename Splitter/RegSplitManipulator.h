@@ -7,7 +7,9 @@
 #include "../Dataset/Dataset.h"
 #include "../Tree/TreeParams.h"
 #include "../Util/Maths.h"
+#include "../Util/Philox.h"
 #include "../Tree/TreeNode.h"
+#include "BinRangeSplit.h"
 
 #define IS_INTEGRAL_FEATURE (std::is_integral<feature_t>::value)
 #define IS_INTEGRAL_LABEL (std::is_integral<label_t>::value)
@@ -104,6 +106,23 @@ class RegSplitManipulator {
     stats.num_samples_right = 0;
   }
 
+  double LowestCostBound() {
+    // shouldn't be called
+    assert(false);
+    return 0.0;
+  }
+
+  void ExportBins(BinRangeSplit &) {
+    // shouldn't be called
+    assert(false);
+  }
+
+  void ImportBins(const BinRangeSplit &,
+                  const TreeNode *) {
+    // shouldn't be called
+    assert(false);
+  }
+
   void Clear() {
     for (uint32_t idx = 0; idx != stats.num_bins; ++idx) {
       uint32_t bin = stats.bin_ids[idx];
@@ -155,8 +174,8 @@ class RegSplitManipulator {
          });
   }
 
-  void MoveOneBinOutOfPlace(uint32_t bin,
-                            double &cost) {
+  void MoveBinsOutOfPlace(uint32_t,
+                          double *) {
     // shouldn't be called
     assert(false);
   }
@@ -206,7 +225,8 @@ class RegSplitManipulator {
   }
 
   void ShuffleBinId(uint32_t n,
-                    uint32_t k) {
+                    uint32_t k,
+                    Philox &) {
     // shouldn't be called
     assert(false);
   }
@@ -4,17 +4,17 @@
 
 #include <cstdint>
 #include <vector>
-#include <mutex>
 
 #include "../Global/GlobalConsts.h"
 #include "../Generics/TypeDefs.h"
 
+/// Best split found on a tree node, or on one feature of a tree node when split finding runs in parallel.
+/// Not synchronized: each split finding job owns the SplitInfo it writes to, see TreeNode::Candidate.
 class SplitInfo {
 
   union Info {
     float float_type;
     uint32_t uint32_type;
-    vec_uint32_t *ptr_type;
   };
 
  public:
@@ -23,24 +23,18 @@ class SplitInfo {
   uint32_t feature_idx;
   double gain;
   Info info;
-  uint32_t num_updates;
 
-  SplitInfo():
-          type(IsUnused), feature_idx(0), gain(0.0), info(), num_updates(0) {};
+  /// Bitmask of the left bins of a high cardinality many-vs-many split.
+  /// Its capacity is kept across updates so that improving a split does not allocate.
+  vec_uint32_t bitmask;
 
-  ~SplitInfo() {
-    if (type == IsHighCardinality) {
-      delete info.ptr_type;
-      info.ptr_type = nullptr;
-    }
-  };
+  SplitInfo():
+          type(IsUnused), feature_idx(0), gain(0.0), info(), bitmask() {};
 
   void UpdateFloat(double gain,
                    uint32_t type,
                    uint32_t feature_idx,
                    float value) {
-    std::unique_lock<std::mutex> lock(updating);
-    ++num_updates;
     if (UpdateGeneral(gain, type, feature_idx))
       this->info.float_type = value;
   }
@@ -49,8 +43,6 @@ class SplitInfo {
                   uint32_t type,
                   uint32_t feature_idx,
                   uint32_t uint32_info) {
-    std::unique_lock<std::mutex> lock(updating);
-    ++num_updates;
     if (UpdateGeneral(gain, type, feature_idx))
       this->info.uint32_type = uint32_info;
   }
@@ -59,10 +51,29 @@ class SplitInfo {
                  uint32_t type,
                  uint32_t feature_idx,
                  const vec_uint32_t &categorical_bitmask) {
-    std::unique_lock<std::mutex> lock(updating);
-    ++num_updates;
     if (UpdateGeneral(gain, type, feature_idx))
-      this->info.ptr_type = new vec_uint32_t(categorical_bitmask);
+      this->bitmask.assign(categorical_bitmask.cbegin(), categorical_bitmask.cend());
+  }
+
+  /// Take over the best of the candidate splits found on individual features.
+  /// Candidates are visited in order so that the result does not depend on which job finished first.
+  void Reduce(std::vector<SplitInfo> &candidates) {
+    for (auto &candidate: candidates)
+      if (candidate.gain - gain >= FloatError) {
+        gain = candidate.gain;
+        type = candidate.type;
+        feature_idx = candidate.feature_idx;
+        info = candidate.info;
+        bitmask.swap(candidate.bitmask);
+      }
+  }
+
+  /// Whether a feature whose gain is at most gain_bound can be skipped,
+  /// gain_to_beat being the gain it would have to reach to change the split found, see TreeBuilder
+  static bool CannotBeat(double gain_bound,
+                         double gain_to_beat,
+                         double node_cost) {
+    return gain_bound + GainBoundSlack * node_cost < gain_to_beat;
   }
 
   void FinishUpdate() {
@@ -70,26 +81,17 @@ class SplitInfo {
   }
 
   void Clear() {
-    if (type == IsHighCardinality) {
-      delete info.ptr_type;
-      info.ptr_type = nullptr;
-    }
     this->type = IsUnused;
     this->feature_idx = 0;
     this->gain = 0.0;
+    this->bitmask.clear();
   }
 
  private:
-  std::mutex updating;
-
   bool UpdateGeneral(double gain,
                      uint32_t type,
                      uint32_t feature_idx) {
     if (gain - this->gain < FloatError) return false;
-    if (this->type == IsHighCardinality) {
-      delete info.ptr_type;
-      info.ptr_type = nullptr;
-    }
     this->gain = gain;
     this->type = type;
     this->feature_idx = feature_idx;
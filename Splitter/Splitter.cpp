@@ -4,28 +4,59 @@
 
 /// Implementation of class Splitter, delegate all calls to SplitterImpl
 
+/// Select the classification splitter specialised for the number of classes of the dataset,
+/// fall back to the dynamically-sized one if there is no specialisation
+template <template <uint32_t> class ClaSplitter>
+static std::unique_ptr<BaseSplitterImpl> MakeClaSplitter(const Dataset *dataset,
+                                                         const TreeParams &params,
+                                                         uint32_t num_workers) {
+  switch (dataset->Meta().num_classes) {
+    case 2:
+      return std::make_unique<ClaSplitter<2>>(dataset, params, num_workers);
+    case 3:
+      return std::make_unique<ClaSplitter<3>>(dataset, params, num_workers);
+    case 4:
+      return std::make_unique<ClaSplitter<4>>(dataset, params, num_workers);
+    case 8:
+      return std::make_unique<ClaSplitter<8>>(dataset, params, num_workers);
+    case 16:
+      return std::make_unique<ClaSplitter<16>>(dataset, params, num_workers);
+    default:
+      return std::make_unique<ClaSplitter<0>>(dataset, params, num_workers);
+  }
+}
+
 Splitter::Splitter(const Dataset *dataset,
-                   const TreeParams &params) {
+                   const TreeParams &params,
+                   uint32_t num_workers) {
   if (params.cost_function == GiniImpurity) {
-    spliiter = std::make_unique<GiniSplitter>(dataset, params);
+    spliiter = MakeClaSplitter<GiniSplitter>(dataset, params, num_workers);
   } else if (params.cost_function == Entropy) {
-    spliiter = std::make_unique<EntropySplitter>(dataset, params);
+    spliiter = MakeClaSplitter<EntropySplitter>(dataset, params, num_workers);
   } else if (params.cost_function == Variance) {
-    spliiter = std::make_unique<VarianceSplitter>(dataset, params);
+    spliiter = std::make_unique<VarianceSplitter>(dataset, params, num_workers);
   }
 }
 
 Splitter::~Splitter() = default;
 
-void Splitter::Split(uint32_t feature_idx,
+bool Splitter::Split(uint32_t worker_idx,
+                     uint32_t feature_idx,
                      uint32_t feature_type,
                      const Dataset *dataset,
-                     TreeNode *node) {
-  spliiter->Split(feature_idx, feature_type, dataset, node);
+                     TreeNode *node,
+                     double gain_to_beat,
+                     SplitInfo *split_info,
+                     std::unique_ptr<BinRangeSplit> *range_split) {
+  return spliiter->Split(worker_idx, feature_idx, feature_type, dataset, node, gain_to_beat, split_info, range_split);
 }
 
-Splitter &Splitter::GetInstance(const Dataset *dataset,
-                                const TreeParams &params) {
-  static Splitter instance(dataset, params);
-  return instance;
+bool Splitter::SplitBinRange(uint32_t worker_idx,
+                             uint32_t feature_idx,
+                             uint32_t range_idx,
+                             const Dataset *dataset,
+                             TreeNode *node,
+                             BinRangeSplit *range_split,
+                             SplitInfo *split_info) {
+  return spliiter->SplitBinRange(worker_idx, feature_idx, range_idx, dataset, node, range_split, split_info);
 }
\ No newline at end of file
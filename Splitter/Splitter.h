@@ -8,27 +8,39 @@ class BaseSplitterImpl;
 class Dataset;
 class TreeParams;
 class TreeNode;
+class SplitInfo;
+class BinRangeSplit;
 
 /// Pimpl class of SplitterImpl
+/// Owned by the TreeBuilder of one build, workers of the build are numbered from 0 to num_workers - 1
 
 class Splitter {
  public:
-  static Splitter &GetInstance(const Dataset *dataset,
-                               const TreeParams &params);
+  Splitter(const Dataset *dataset,
+           const TreeParams &params,
+           uint32_t num_workers);
   ~Splitter();
   Splitter(const Splitter &splitter) = delete;
   Splitter(Splitter &&splitter) = delete;
   Splitter &operator=(const Splitter &splitter) = delete;
   Splitter &operator=(Splitter &&splitter) = delete;
-  void Split(uint32_t feature_idx,
+  bool Split(uint32_t worker_idx,
+             uint32_t feature_idx,
              uint32_t feature_type,
              const Dataset *dataset,
-             TreeNode *node);
+             TreeNode *node,
+             double gain_to_beat,
+             SplitInfo *split_info,
+             std::unique_ptr<BinRangeSplit> *range_split);
+  bool SplitBinRange(uint32_t worker_idx,
+                     uint32_t feature_idx,
+                     uint32_t range_idx,
+                     const Dataset *dataset,
+                     TreeNode *node,
+                     BinRangeSplit *range_split,
+                     SplitInfo *split_info);
  private:
   std::unique_ptr<BaseSplitterImpl> spliiter;
-
-  Splitter(const Dataset *datatset,
-           const TreeParams &params);
 };
 
 #endif
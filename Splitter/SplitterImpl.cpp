@@ -1,111 +1,174 @@
 
 #include <cstdint>
 #include <cfloat>
+#include <array>
 #include <boost/variant.hpp>
 #include "SplitterImpl.h"
 
 template <typename SplitManipulatorType>
-thread_local std::unique_ptr<SplitManipulatorType> SplitterImpl<SplitManipulatorType>::split_manipulator = nullptr;
+SplitterImpl<SplitManipulatorType>::SplitterImpl(const Dataset *dataset,
+                                                 const TreeParams &params,
+                                                 uint32_t num_workers):
+  BaseSplitterImpl::BaseSplitterImpl(), split_manipulators(num_workers), params(params),
+  cost_function(params.cost_function), num_classes(dataset->Meta().num_classes) {}
 
+/// Manipulators are created on the first call of each worker, a worker that never splits costs nothing
 template <typename SplitManipulatorType>
-SplitterImpl<SplitManipulatorType>::SplitterImpl(const Dataset *dataset,
-                                                 const TreeParams &params):
-  BaseSplitterImpl::BaseSplitterImpl(), cost_function(params.cost_function),
-  num_classes(dataset->Meta().num_classes), params(params) {}
+SplitManipulatorType &SplitterImpl<SplitManipulatorType>::Manipulator(const uint32_t worker_idx,
+                                                                      const Dataset *dataset) {
+  auto &worker_manipulator = split_manipulators[worker_idx];
+  if (!worker_manipulator)
+    worker_manipulator = std::make_unique<SplitManipulatorType>(dataset, params);
+  return *worker_manipulator;
+}
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::Split(const uint32_t feature_idx,
+bool SplitterImpl<SplitManipulatorType>::Split(const uint32_t worker_idx,
+                                               const uint32_t feature_idx,
                                                const uint32_t feature_type,
                                                const Dataset *dataset,
-                                               TreeNode *node) {
-  if (!split_manipulator)
-    split_manipulator = std::make_unique<SplitManipulatorType>(dataset, params);
+                                               TreeNode *node,
+                                               const double gain_to_beat,
+                                               SplitInfo *split_info,
+                                               std::unique_ptr<BinRangeSplit> *range_split) {
+  SplitManipulatorType &split_manipulator = Manipulator(worker_idx, dataset);
   if (feature_type == IsContinuous) {
-    boost::apply_visitor([this, &feature_idx, &dataset, &node] (const auto &features, const auto &labels) {
-      this->ContinuousSplit(features, labels, node->Subset()->SortedSampleWeights(feature_idx),
-                            feature_idx, node);
-    }, dataset->Features(feature_idx), node->Subset()->SortedLabels(feature_idx));
+    boost::apply_visitor(
+      [this, &split_manipulator, &feature_idx, &dataset, &node, &split_info] (const auto &features,
+                                                                              const auto &labels) {
+        this->ContinuousSplit(split_manipulator, features, labels, node->Subset()->SortedSampleWeights(feature_idx),
+                              feature_idx, node, split_info);
+      }, dataset->Features(feature_idx), node->Subset()->SortedLabels(feature_idx));
+    return true;
   } else {
-    boost::apply_visitor([this, &feature_idx, &feature_type, &node] (const auto &features, const auto &labels) {
-      this->DiscreteSplit(features, labels, node->Subset()->SampleWeights(),
-                          feature_idx, feature_type, node);
-    }, node->Subset()->Features(feature_idx), node->Subset()->Labels());
+    return boost::apply_visitor(
+      [this, &split_manipulator, &feature_idx, &feature_type, &node, &gain_to_beat, &split_info,
+       &range_split] (const auto &features, const auto &labels) {
+        return this->DiscreteSplit(split_manipulator, features, labels, node->Subset()->SampleWeights(),
+                                   feature_idx, feature_type, node, gain_to_beat, split_info, range_split);
+      }, node->Subset()->Features(feature_idx), node->Subset()->Labels());
+  }
+}
+
+template <typename SplitManipulatorType>
+bool SplitterImpl<SplitManipulatorType>::SplitBinRange(const uint32_t worker_idx,
+                                                       const uint32_t feature_idx,
+                                                       const uint32_t range_idx,
+                                                       const Dataset *dataset,
+                                                       TreeNode *node,
+                                                       BinRangeSplit *range_split,
+                                                       SplitInfo *split_info) {
+  SplitManipulatorType &split_manipulator = Manipulator(worker_idx, dataset);
+  split_manipulator.ImportBins(*range_split, node);
+  range_split->lowest_costs[range_idx] = node->Stats()->Cost();
+  BruteSplitRange(split_manipulator, range_split->RangeBegin(range_idx), range_split->RangeEnd(range_idx),
+                  range_split->lowest_costs[range_idx], range_split->best_bitmasks[range_idx]);
+  bool last_range = range_split->FinishRange();
+  if (last_range) {
+    double lowest_cost = node->Stats()->Cost();
+    uint32_t best_bitmask = range_split->Reduce(lowest_cost);
+    UpdateBruteSplit(split_manipulator, best_bitmask, feature_idx, node->Stats()->Cost() - lowest_cost, node,
+                     split_info);
   }
+  split_manipulator.Clear();
+  return last_range;
 }
 
 template <typename SplitManipulatorType>
 template <typename feature_t, typename label_t>
 std::enable_if_t<IS_VALID_LABEL && !IS_INTEGRAL_FEATURE, void>
-SplitterImpl<SplitManipulatorType>::ContinuousSplit(const vector<feature_t> &features,
+SplitterImpl<SplitManipulatorType>::ContinuousSplit(SplitManipulatorType &split_manipulator,
+                                                    const vector<feature_t> &features,
                                                     const vector<label_t> &labels,
                                                     const vec_uint32_t &sample_weights,
                                                     const uint32_t feature_idx,
-                                                    TreeNode *node) {
-  split_manipulator->NumericalInit(node);
-  NumericalSplitter(features, labels, sample_weights, feature_idx, node);
+                                                    TreeNode *node,
+                                                    SplitInfo *split_info) {
+  split_manipulator.NumericalInit(node);
+  NumericalSplitter(split_manipulator, features, labels, sample_weights, feature_idx, node, split_info);
 }
 
 template <typename SplitManipulatorType>
 template <typename feature_t, typename label_t>
 std::enable_if_t<!IS_VALID_LABEL || IS_INTEGRAL_FEATURE, void>
-SplitterImpl<SplitManipulatorType>::ContinuousSplit(const vector<feature_t> &features,
+SplitterImpl<SplitManipulatorType>::ContinuousSplit(SplitManipulatorType &,
+                                                    const vector<feature_t> &features,
                                                     const vector<label_t> &labels,
                                                     const vec_uint32_t &sample_weights,
                                                     const uint32_t feature_idx,
-                                                    TreeNode *node) {
+                                                    TreeNode *node,
+                                                    SplitInfo *) {
   // shouldn't be called
   assert(false);
 }
 
 template <typename SplitManipulatorType>
 template <typename feature_t, typename label_t>
-std::enable_if_t<IS_VALID_LABEL && IS_INTEGRAL_FEATURE, void>
-SplitterImpl<SplitManipulatorType>::DiscreteSplit(const vector<feature_t> &features,
+std::enable_if_t<IS_VALID_LABEL && IS_INTEGRAL_FEATURE, bool>
+SplitterImpl<SplitManipulatorType>::DiscreteSplit(SplitManipulatorType &split_manipulator,
+                                                  const vector<feature_t> &features,
                                                   const vector<label_t> &labels,
                                                   const vec_uint32_t &sample_weights,
                                                   const uint32_t feature_idx,
                                                   const uint32_t feature_type,
-                                                  TreeNode *node) {
-  split_manipulator->DiscreteInit(features, labels, sample_weights, feature_idx, node);
-  if (split_manipulator->NumBins() > 1) {
+                                                  TreeNode *node,
+                                                  const double gain_to_beat,
+                                                  SplitInfo *split_info,
+                                                  std::unique_ptr<BinRangeSplit> *range_split) {
+  split_manipulator.DiscreteInit(features, labels, sample_weights, feature_idx, node);
+  bool scanned = true;
+  if (split_manipulator.NumBins() > 1) {
     if (feature_type == IsOrdinal) {
-      OrdinalSplitter(feature_idx, node);
+      OrdinalSplitter(split_manipulator, feature_idx, node, split_info);
     } else if (feature_type == IsOneVsAll) {
-      OneVsAllSplitter(feature_idx, node);
+      OneVsAllSplitter(split_manipulator, feature_idx, node, split_info);
     } else if (feature_type == IsManyVsMany) {
       if (cost_function == Variance || num_classes == 2) {
-        LinearSplitter(feature_idx, node);
-      } else if (split_manipulator->NumBins() <= MaxNumBinsForBruteSplitter) {
-        BruteSplitter(feature_idx, node);
+        LinearSplitter(split_manipulator, feature_idx, node, split_info);
+      } else if (SplitInfo::CannotBeat(node->Stats()->Cost() - split_manipulator.LowestCostBound(), gain_to_beat,
+                                       node->Stats()->Cost())) {
+        // the bound costs as much as a linear scan over the bins, it only pays off before the searches below
+        scanned = false;
+      } else if (split_manipulator.NumBins() <= MaxNumBinsForBruteSplitter) {
+        if (!range_split || !ParallelBruteSplitter(split_manipulator, feature_idx, node, range_split))
+          BruteSplitter(split_manipulator, feature_idx, node, split_info);
       } else {
-        GreedySplitter(feature_idx, node);
+        GreedySplitter(split_manipulator, feature_idx, node, split_info);
       }
     }
   }
-  split_manipulator->Clear();
+  split_manipulator.Clear();
+  return scanned;
 }
 
 template <typename SplitManipulatorType>
 template <typename feature_t, typename label_t>
-std::enable_if_t<!IS_VALID_LABEL || !IS_INTEGRAL_FEATURE, void>
-SplitterImpl<SplitManipulatorType>::DiscreteSplit(const vector<feature_t> &features,
+std::enable_if_t<!IS_VALID_LABEL || !IS_INTEGRAL_FEATURE, bool>
+SplitterImpl<SplitManipulatorType>::DiscreteSplit(SplitManipulatorType &,
+                                                  const vector<feature_t> &features,
                                                   const vector<label_t> &labels,
                                                   const vec_uint32_t &sample_weights,
                                                   const uint32_t feature_idx,
                                                   const uint32_t feature_type,
-                                                  TreeNode *node) {
+                                                  TreeNode *node,
+                                                  const double,
+                                                  SplitInfo *,
+                                                  std::unique_ptr<BinRangeSplit> *) {
   // shouldn't be called
   assert(false);
+  return false;
 }
 
 template <typename SplitManipulatorType>
 template <typename feature_t, typename label_t>
 std::enable_if_t<IS_VALID_LABEL && !IS_INTEGRAL_FEATURE, void>
-SplitterImpl<SplitManipulatorType>::NumericalSplitter(const vector<feature_t> &features,
+SplitterImpl<SplitManipulatorType>::NumericalSplitter(SplitManipulatorType &split_manipulator,
+                                                      const vector<feature_t> &features,
                                                       const vector<label_t> &labels,
                                                       const vec_uint32_t &sample_weights,
                                                       const uint32_t feature_idx,
-                                                      TreeNode *node) {
+                                                      TreeNode *node,
+                                                      SplitInfo *split_info) {
   double lowest_cost = node->Stats()->Cost();
   double cost = 0.0;
   uint32_t best_idx = 0;
@@ -114,76 +177,82 @@ SplitterImpl<SplitManipulatorType>::NumericalSplitter(const vector<feature_t> &f
   const vector<uint32_t> &sorted_idx = node->Subset()->SortedIdx(feature_idx);
 
   for (uint32_t idx = 0; idx != node->Size() - 1; ++idx) {
-    split_manipulator->MoveOneSample(labels, sample_weights, idx, cost);
-    if (split_manipulator->LessThanMinLeafNode()) continue;
-    if (cost < lowest_cost && split_manipulator->Splittable(features, sample_ids, sorted_idx, idx)) {
+    split_manipulator.MoveOneSample(labels, sample_weights, idx, cost);
+    if (split_manipulator.LessThanMinLeafNode()) continue;
+    if (cost < lowest_cost && split_manipulator.Splittable(features, sample_ids, sorted_idx, idx)) {
       lowest_cost = cost;
       best_idx = idx;
     }
   }
 
-  float threshold = split_manipulator->NumericalThreshold(features, sample_ids, sorted_idx, best_idx);
-  node->Split()->UpdateFloat(node->Stats()->Cost() - lowest_cost, IsContinuous, feature_idx, threshold);
+  float threshold = split_manipulator.NumericalThreshold(features, sample_ids, sorted_idx, best_idx);
+  split_info->UpdateFloat(node->Stats()->Cost() - lowest_cost, IsContinuous, feature_idx, threshold);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::OrdinalSplitter(const uint32_t feature_idx,
-                                                         TreeNode *node) {
+void SplitterImpl<SplitManipulatorType>::OrdinalSplitter(SplitManipulatorType &split_manipulator,
+                                                         const uint32_t feature_idx,
+                                                         TreeNode *node,
+                                                         SplitInfo *split_info) {
   double lowest_cost = node->Stats()->Cost();
   double cost = 0.0;
   uint32_t best_ordinal_ceiling = 0;
 
-  uint32_t num_bins = split_manipulator->NumBins();
+  uint32_t num_bins = split_manipulator.NumBins();
 
   for (uint32_t idx = 0; idx != num_bins; ++idx) {
-    uint32_t bin = split_manipulator->BinId(idx);
-    split_manipulator->MoveOneBinLToR(bin, cost);
-    if (split_manipulator->LessThanMinLeafNode()) continue;
+    uint32_t bin = split_manipulator.BinId(idx);
+    split_manipulator.MoveOneBinLToR(bin, cost);
+    if (split_manipulator.LessThanMinLeafNode()) continue;
     if (cost < lowest_cost) {
       lowest_cost = cost;
       best_ordinal_ceiling = bin;
     }
   }
 
-  node->Split()->UpdateUInt(node->Stats()->Cost() - lowest_cost, IsOrdinal, feature_idx, best_ordinal_ceiling);
+  split_info->UpdateUInt(node->Stats()->Cost() - lowest_cost, IsOrdinal, feature_idx, best_ordinal_ceiling);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::OneVsAllSplitter(const uint32_t feature_idx,
-                                                          TreeNode *node) {
+void SplitterImpl<SplitManipulatorType>::OneVsAllSplitter(SplitManipulatorType &split_manipulator,
+                                                          const uint32_t feature_idx,
+                                                          TreeNode *node,
+                                                          SplitInfo *split_info) {
   double lowest_cost = node->Stats()->Cost();
   double cost = 0.0;
   uint32_t best_on_vs_all = 0;
 
-  uint32_t num_bins = split_manipulator->NumBins();
+  uint32_t num_bins = split_manipulator.NumBins();
 
   for (uint32_t idx = 0; idx != num_bins; ++idx) {
-    uint32_t bin = split_manipulator->BinId(idx);
-    split_manipulator->SetOneVsAll(bin, cost);
-    if (split_manipulator->LessThanMinLeafNode()) continue;
+    uint32_t bin = split_manipulator.BinId(idx);
+    split_manipulator.SetOneVsAll(bin, cost);
+    if (split_manipulator.LessThanMinLeafNode()) continue;
     if (cost < lowest_cost) {
       lowest_cost = cost;
       best_on_vs_all = bin;
     }
   }
 
-  node->Split()->UpdateUInt(node->Stats()->Cost() - lowest_cost, IsOneVsAll, feature_idx, best_on_vs_all);
+  split_info->UpdateUInt(node->Stats()->Cost() - lowest_cost, IsOneVsAll, feature_idx, best_on_vs_all);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::LinearSplitter(const uint32_t feature_idx,
-                                                        TreeNode *node) {
+void SplitterImpl<SplitManipulatorType>::LinearSplitter(SplitManipulatorType &split_manipulator,
+                                                        const uint32_t feature_idx,
+                                                        TreeNode *node,
+                                                        SplitInfo *split_info) {
   double lowest_cost = node->Stats()->Cost();
   double cost = 0.0;
   uint32_t best_linear_ceiling = 0;
 
-  split_manipulator->ReorderBinIds();
-  uint32_t num_bins = split_manipulator->NumBins();
+  split_manipulator.ReorderBinIds();
+  uint32_t num_bins = split_manipulator.NumBins();
 
   for (uint32_t idx = 0; idx != num_bins; ++idx) {
-    uint32_t bin = split_manipulator->BinId(idx);
-    split_manipulator->MoveOneBinLToR(bin, cost);
-    if (split_manipulator->LessThanMinLeafNode()) continue;
+    uint32_t bin = split_manipulator.BinId(idx);
+    split_manipulator.MoveOneBinLToR(bin, cost);
+    if (split_manipulator.LessThanMinLeafNode()) continue;
     if (cost < lowest_cost) {
       lowest_cost = cost;
       best_linear_ceiling = idx;
@@ -192,69 +261,100 @@ void SplitterImpl<SplitManipulatorType>::LinearSplitter(const uint32_t feature_i
 
   vec_uint32_t indicators(best_linear_ceiling + 1, 0);
   iota(indicators.begin(), indicators.end(), 0);
-  UpdateManyVsManySplit(indicators, feature_idx, node->Stats()->Cost() - lowest_cost, node);
+  UpdateManyVsManySplit(split_manipulator, indicators, feature_idx, node->Stats()->Cost() - lowest_cost, node,
+                        split_info);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::BruteSplitter(const uint32_t feature_idx,
-                                                       TreeNode *node){
+void SplitterImpl<SplitManipulatorType>::BruteSplitter(SplitManipulatorType &split_manipulator,
+                                                       const uint32_t feature_idx,
+                                                       TreeNode *node,
+                                                       SplitInfo *split_info){
   double lowest_cost = node->Stats()->Cost();
-  double cost = 0.0;
   uint32_t best_bitmask = 0;
 
-  uint32_t num_bins = split_manipulator->NumBins();
-  uint32_t num_flips = 1u << (num_bins - 1);
-  uint32_t bitmask = 0x0;
-  for (uint32_t ite = 1; ite != num_flips; ++ite) {
+  uint32_t num_flips = 1u << (split_manipulator.NumBins() - 1);
+  BruteSplitRange(split_manipulator, 1, num_flips, lowest_cost, best_bitmask);
+
+  UpdateBruteSplit(split_manipulator, best_bitmask, feature_idx, node->Stats()->Cost() - lowest_cost, node, split_info);
+}
+
+/// Hand the bins over to range jobs if there are enough assignments to share out.
+/// Return false if the search is small enough to be done right here.
+template <typename SplitManipulatorType>
+bool SplitterImpl<SplitManipulatorType>::ParallelBruteSplitter(SplitManipulatorType &split_manipulator,
+                                                               const uint32_t,
+                                                               TreeNode *,
+                                                               std::unique_ptr<BinRangeSplit> *range_split) {
+  uint32_t num_bins = split_manipulator.NumBins();
+  uint32_t num_ranges = (1u << (num_bins - 1)) / NumFlipsPerBruteRange;
+  if (num_ranges <= 1) return false;
+  *range_split = std::make_unique<BinRangeSplit>(num_bins, num_classes, num_ranges);
+  split_manipulator.ExportBins(**range_split);
+  return true;
+}
+
+/// Enumerate assignments begin to end - 1 of the Gray code sequence, so that consecutive assignments differ by
+/// one bin. Bins of assignment begin - 1 are moved to the right first, so that a range can start anywhere.
+template <typename SplitManipulatorType>
+void SplitterImpl<SplitManipulatorType>::BruteSplitRange(SplitManipulatorType &split_manipulator,
+                                                         const uint32_t begin,
+                                                         const uint32_t end,
+                                                         double &lowest_cost,
+                                                         uint32_t &best_bitmask) {
+  double cost = 0.0;
+  uint32_t bitmask = (begin - 1) ^ ((begin - 1) >> 1);
+  for (uint32_t idx = 0; idx != split_manipulator.NumBins(); ++idx)
+    if (bitmask & (1u << idx))
+      split_manipulator.MoveOneBinLToR(split_manipulator.BinId(idx), cost);
+
+  for (uint32_t ite = begin; ite != end; ++ite) {
     uint32_t idx = static_cast<uint32_t>(ffs(ite) - 1);
     uint32_t mask = 1u << idx;
     bool left_to_right = !(bitmask & mask);
     bitmask ^= mask;
-    uint32_t bin = split_manipulator->BinId(idx);
+    uint32_t bin = split_manipulator.BinId(idx);
     if (left_to_right) {
-      split_manipulator->MoveOneBinLToR(bin, cost);
+      split_manipulator.MoveOneBinLToR(bin, cost);
     } else {
-      split_manipulator->MoveOneBinRToL(bin, cost);
+      split_manipulator.MoveOneBinRToL(bin, cost);
     }
-    if (split_manipulator->LessThanMinLeafNode()) continue;
+    if (split_manipulator.LessThanMinLeafNode()) continue;
     if (cost < lowest_cost) {
       lowest_cost = cost;
       best_bitmask = bitmask;
     }
   }
-
-  vec_uint32_t indicators;
-  for (uint32_t idx = 0; idx != num_bins; ++idx)
-    if (best_bitmask & (1 << idx))
-      indicators.push_back(idx);
-  UpdateManyVsManySplit(indicators, feature_idx, node->Stats()->Cost() - lowest_cost, node);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::GreedySplitter(const uint32_t feature_idx,
-                                                        TreeNode *node) {
+void SplitterImpl<SplitManipulatorType>::GreedySplitter(SplitManipulatorType &split_manipulator,
+                                                        const uint32_t feature_idx,
+                                                        TreeNode *node,
+                                                        SplitInfo *split_info) {
   double global_lowest_cost = node->Stats()->Cost();
   double lowest_cost = DBL_MAX;
-  double cost = 0.0;
+  std::array<double, MaxNumBinsForSampling> costs;
   uint32_t best_idx = 0;
   uint32_t best_num_bins_left = 0;
 
-  uint32_t num_bins = split_manipulator->NumBins();
+  uint32_t num_bins = split_manipulator.NumBins();
+  // the bins sampled depend on the node and feature, not on the worker searching them
+  Philox generator(params.random_state, Random::Stream(node->Key(), feature_idx + 1));
 
   for (uint32_t num_bins_left = num_bins; num_bins_left != 1; --num_bins_left) {
     uint32_t num_bins_to_sample = (num_bins_left < MaxNumBinsForSampling)? num_bins_left : MaxNumBinsForSampling;
-    split_manipulator->ShuffleBinId(num_bins_left, num_bins_to_sample);
+    split_manipulator.ShuffleBinId(num_bins_left, num_bins_to_sample, generator);
+    split_manipulator.MoveBinsOutOfPlace(num_bins_to_sample, costs.data());
     for (uint32_t idx = 0; idx != num_bins_to_sample; ++idx) {
-      uint32_t bin = split_manipulator->BinId(idx);
-      split_manipulator->MoveOneBinOutOfPlace(bin, cost);
-      if (cost < lowest_cost) {
-        lowest_cost = cost;
+      if (costs[idx] < lowest_cost) {
+        lowest_cost = costs[idx];
         best_idx = idx;
       }
     }
-    split_manipulator->MoveOneBinInPlace(split_manipulator->BinId(best_idx));
-    split_manipulator->SwitchWithLast(best_idx, num_bins_left);
-    if (lowest_cost < global_lowest_cost && !split_manipulator->LessThanMinLeafNode()) {
+    split_manipulator.MoveOneBinInPlace(split_manipulator.BinId(best_idx));
+    split_manipulator.SwitchWithLast(best_idx, num_bins_left);
+    if (lowest_cost < global_lowest_cost && !split_manipulator.LessThanMinLeafNode()) {
       global_lowest_cost = lowest_cost;
       best_num_bins_left = num_bins_left - 1;
     }
@@ -263,35 +363,63 @@ void SplitterImpl<SplitManipulatorType>::GreedySplitter(const uint32_t feature_i
 
   vec_uint32_t indicators(best_num_bins_left, 0);
   std::iota(indicators.begin(), indicators.end(), 0);
-  UpdateManyVsManySplit(indicators, feature_idx, node->Stats()->Cost() - global_lowest_cost, node);
+  UpdateManyVsManySplit(split_manipulator, indicators, feature_idx, node->Stats()->Cost() - global_lowest_cost, node,
+                        split_info);
 }
 
 template <typename SplitManipulatorType>
-void SplitterImpl<SplitManipulatorType>::UpdateManyVsManySplit(const vec_uint32_t &indicators,
+void SplitterImpl<SplitManipulatorType>::UpdateBruteSplit(SplitManipulatorType &split_manipulator,
+                                                          const uint32_t best_bitmask,
+                                                          const uint32_t feature_idx,
+                                                          const double gain,
+                                                          TreeNode *node,
+                                                          SplitInfo *split_info) {
+  vec_uint32_t indicators;
+  for (uint32_t idx = 0; idx != split_manipulator.NumBins(); ++idx)
+    if (best_bitmask & (1 << idx))
+      indicators.push_back(idx);
+  UpdateManyVsManySplit(split_manipulator, indicators, feature_idx, gain, node, split_info);
+}
+
+template <typename SplitManipulatorType>
+void SplitterImpl<SplitManipulatorType>::UpdateManyVsManySplit(SplitManipulatorType &split_manipulator,
+                                                               const vec_uint32_t &indicators,
                                                                const uint32_t feature_idx,
                                                                const double gain,
-                                                               TreeNode *node) {
-  uint32_t max_num_bins = split_manipulator->MaxNumBins(feature_idx);
+                                                               TreeNode *,
+                                                               SplitInfo *split_info) {
+  uint32_t max_num_bins = split_manipulator.MaxNumBins(feature_idx);
   if (max_num_bins <= NumBitsPerWord) {
     uint32_t bitmask = 0;
     for (const auto &idx: indicators) {
-      uint32_t bin = split_manipulator->BinId(idx);
+      uint32_t bin = split_manipulator.BinId(idx);
       bitmask |= (1 << bin);
     }
-    node->Split()->UpdateUInt(gain, IsLowCardinality, feature_idx, bitmask);
+    split_info->UpdateUInt(gain, IsLowCardinality, feature_idx, bitmask);
   } else {
+    /// reused across calls on the same thread, so that the hot path does not allocate
+    static thread_local vec_uint32_t bitmask;
     uint32_t bitmask_size = (max_num_bins + NumBitsPerWord - 1) / NumBitsPerWord;
-    vec_uint32_t bitmask(bitmask_size, 0);
+    bitmask.assign(bitmask_size, 0);
     for (const auto &idx: indicators) {
-      uint32_t bin = split_manipulator->BinId(idx);
+      uint32_t bin = split_manipulator.BinId(idx);
       uint32_t mask_idx = bin >> GetMaskIdx;
       uint32_t mask_shift = bin & GetMaskShift;
       bitmask[mask_idx] |= (1 << mask_shift);
     }
-    node->Split()->UpdatePtr(gain, IsHighCardinality, feature_idx, bitmask);
+    split_info->UpdatePtr(gain, IsHighCardinality, feature_idx, bitmask);
   }
 }
 
-template class SplitterImpl<GiniSplitManipulator>;
-template class SplitterImpl<EntropySplitManipulator>;
+/// explicit instantiation of classification splitters for every number of classes Splitter dispatches on
+#define SPLITTERIMPL_CLASSIFICATION(num_classes) \
+template class SplitterImpl<GiniSplitManipulator<num_classes>>; \
+template class SplitterImpl<EntropySplitManipulator<num_classes>>;
+SPLITTERIMPL_CLASSIFICATION(0)
+SPLITTERIMPL_CLASSIFICATION(2)
+SPLITTERIMPL_CLASSIFICATION(3)
+SPLITTERIMPL_CLASSIFICATION(4)
+SPLITTERIMPL_CLASSIFICATION(8)
+SPLITTERIMPL_CLASSIFICATION(16)
+
 template class SplitterImpl<VarianceSplitManipulator>;
\ No newline at end of file
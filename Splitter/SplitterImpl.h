@@ -13,88 +13,160 @@
 class Dataset;
 class TreeParams;
 class TreeNode;
+class SplitInfo;
 
 class BaseSplitterImpl {
  public:
   BaseSplitterImpl() = default;
   virtual ~BaseSplitterImpl() = default;
-  virtual void Split(const uint32_t feature_idx,
+  /// Return false if the scan was skipped because the feature cannot beat gain_to_beat
+  virtual bool Split(const uint32_t worker_idx,
+                     const uint32_t feature_idx,
                      const uint32_t feature_type,
                      const Dataset *dataset,
-                     TreeNode *node) = 0;
+                     TreeNode *node,
+                     const double gain_to_beat,
+                     SplitInfo *split_info,
+                     std::unique_ptr<BinRangeSplit> *range_split) = 0;
+  virtual bool SplitBinRange(const uint32_t worker_idx,
+                             const uint32_t feature_idx,
+                             const uint32_t range_idx,
+                             const Dataset *dataset,
+                             TreeNode *node,
+                             BinRangeSplit *range_split,
+                             SplitInfo *split_info) = 0;
 };
 
 template <typename SplitManipulatorType>
 class SplitterImpl: public BaseSplitterImpl {
  public:
   SplitterImpl(const Dataset *dataset,
-               const TreeParams &params);
-  void Split(const uint32_t feature_idx,
+               const TreeParams &params,
+               uint32_t num_workers);
+  bool Split(const uint32_t worker_idx,
+             const uint32_t feature_idx,
              const uint32_t feature_type,
              const Dataset *dataset,
-             TreeNode *node) override;
+             TreeNode *node,
+             const double gain_to_beat,
+             SplitInfo *split_info,
+             std::unique_ptr<BinRangeSplit> *range_split) override;
+  bool SplitBinRange(const uint32_t worker_idx,
+                     const uint32_t feature_idx,
+                     const uint32_t range_idx,
+                     const Dataset *dataset,
+                     TreeNode *node,
+                     BinRangeSplit *range_split,
+                     SplitInfo *split_info) override;
 
  private:
-  static thread_local std::unique_ptr<SplitManipulatorType> split_manipulator;
+  /// One manipulator per worker of the build, bound to the dataset and params of the build. The manipulator of the
+  /// worker in a call is handed down to every step of the search.
+  std::vector<std::unique_ptr<SplitManipulatorType>> split_manipulators;
   const TreeParams &params;
   uint32_t cost_function;
   uint32_t num_classes;
 
+  SplitManipulatorType &Manipulator(const uint32_t worker_idx,
+                                    const Dataset *dataset);
   template <typename feature_t, typename label_t>
   std::enable_if_t<IS_VALID_LABEL && !IS_INTEGRAL_FEATURE, void>
-  ContinuousSplit(const vector<feature_t> &features,
+  ContinuousSplit(SplitManipulatorType &split_manipulator,
+                  const vector<feature_t> &features,
                   const vector<label_t> &labels,
                   const vec_uint32_t &sample_weights,
                   const uint32_t feature_idx,
-                  TreeNode *node);
+                  TreeNode *node,
+                  SplitInfo *split_info);
   template <typename feature_t, typename label_t>
   std::enable_if_t<!IS_VALID_LABEL || IS_INTEGRAL_FEATURE, void>
-  ContinuousSplit(const vector<feature_t> &features,
+  ContinuousSplit(SplitManipulatorType &split_manipulator,
+                  const vector<feature_t> &features,
                   const vector<label_t> &labels,
                   const vec_uint32_t &sample_weights,
                   const uint32_t feature_idx,
-                  TreeNode *node);
+                  TreeNode *node,
+                  SplitInfo *split_info);
   template <typename feature_t, typename label_t>
-  std::enable_if_t<IS_VALID_LABEL && IS_INTEGRAL_FEATURE, void>
-  DiscreteSplit(const vector<feature_t> &features,
+  std::enable_if_t<IS_VALID_LABEL && IS_INTEGRAL_FEATURE, bool>
+  DiscreteSplit(SplitManipulatorType &split_manipulator,
+                const vector<feature_t> &features,
                 const vector<label_t> &labels,
                 const vec_uint32_t &sample_weights,
                 const uint32_t feature_idx,
                 const uint32_t feature_type,
-                TreeNode *node);
+                TreeNode *node,
+                const double gain_to_beat,
+                SplitInfo *split_info,
+                std::unique_ptr<BinRangeSplit> *range_split);
   template <typename feature_t, typename label_t>
-  std::enable_if_t<!IS_VALID_LABEL || !IS_INTEGRAL_FEATURE, void>
-  DiscreteSplit(const vector<feature_t> &features,
+  std::enable_if_t<!IS_VALID_LABEL || !IS_INTEGRAL_FEATURE, bool>
+  DiscreteSplit(SplitManipulatorType &split_manipulator,
+                const vector<feature_t> &features,
                 const vector<label_t> &labels,
                 const vec_uint32_t &sample_weights,
                 const uint32_t feature_idx,
                 const uint32_t feature_type,
-                TreeNode *node);
+                TreeNode *node,
+                const double gain_to_beat,
+                SplitInfo *split_info,
+                std::unique_ptr<BinRangeSplit> *range_split);
   template <typename feature_t, typename label_t>
   std::enable_if_t<IS_VALID_LABEL && !IS_INTEGRAL_FEATURE, void>
-  NumericalSplitter(const vector<feature_t> &features,
+  NumericalSplitter(SplitManipulatorType &split_manipulator,
+                    const vector<feature_t> &features,
                     const vector<label_t> &labels,
                     const vec_uint32_t &sample_weights,
                     const uint32_t feature_idx,
-                    TreeNode *node);
-  void OrdinalSplitter(const uint32_t feature_idx,
-                       TreeNode *node);
-  void OneVsAllSplitter(const uint32_t feature_idx,
-                        TreeNode *node);
-  void LinearSplitter(const uint32_t feature_idx,
-                      TreeNode *node);
-  void BruteSplitter(const uint32_t feature_idx,
-                     TreeNode *node);
-  void GreedySplitter(const uint32_t feature_idx,
-                      TreeNode *node);
-  void UpdateManyVsManySplit(const vec_uint32_t &indicators,
+                    TreeNode *node,
+                    SplitInfo *split_info);
+  void OrdinalSplitter(SplitManipulatorType &split_manipulator,
+                       const uint32_t feature_idx,
+                       TreeNode *node,
+                       SplitInfo *split_info);
+  void OneVsAllSplitter(SplitManipulatorType &split_manipulator,
+                        const uint32_t feature_idx,
+                        TreeNode *node,
+                        SplitInfo *split_info);
+  void LinearSplitter(SplitManipulatorType &split_manipulator,
+                      const uint32_t feature_idx,
+                      TreeNode *node,
+                      SplitInfo *split_info);
+  void BruteSplitter(SplitManipulatorType &split_manipulator,
+                     const uint32_t feature_idx,
+                     TreeNode *node,
+                     SplitInfo *split_info);
+  bool ParallelBruteSplitter(SplitManipulatorType &split_manipulator,
+                             const uint32_t feature_idx,
+                             TreeNode *node,
+                             std::unique_ptr<BinRangeSplit> *range_split);
+  void BruteSplitRange(SplitManipulatorType &split_manipulator,
+                       const uint32_t begin,
+                       const uint32_t end,
+                       double &lowest_cost,
+                       uint32_t &best_bitmask);
+  void GreedySplitter(SplitManipulatorType &split_manipulator,
+                      const uint32_t feature_idx,
+                      TreeNode *node,
+                      SplitInfo *split_info);
+  void UpdateBruteSplit(SplitManipulatorType &split_manipulator,
+                        const uint32_t best_bitmask,
+                        const uint32_t feature_idx,
+                        const double gain,
+                        TreeNode *node,
+                        SplitInfo *split_info);
+  void UpdateManyVsManySplit(SplitManipulatorType &split_manipulator,
+                             const vec_uint32_t &indicators,
                              const uint32_t feature_idx,
                              const double gain,
-                             TreeNode *node);
+                             TreeNode *node,
+                             SplitInfo *split_info);
 };
 
-using GiniSplitter = SplitterImpl<GiniSplitManipulator>;
-using EntropySplitter = SplitterImpl<EntropySplitManipulator>;
+template <uint32_t NumClasses = 0>
+using GiniSplitter = SplitterImpl<GiniSplitManipulator<NumClasses>>;
+template <uint32_t NumClasses = 0>
+using EntropySplitter = SplitterImpl<EntropySplitManipulator<NumClasses>>;
 using VarianceSplitter = SplitterImpl<VarianceSplitManipulator>;
 
 #endif
@@ -0,0 +1,23 @@
+
+#ifndef DECISIONTREE_CHECK_H
+#define DECISIONTREE_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+/// assert for the tests and benchmarks, kept in release builds as well: a failed check prints where it failed
+/// and aborts the run
+#define CHECK(condition) \
+  ((condition)? static_cast<void>(0) : Check::Fail(#condition, __FILE__, __LINE__))
+
+namespace Check {
+
+[[noreturn]] inline void Fail(const char *condition,
+                              const char *file,
+                              int line) {
+  std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+  std::abort();
+}
+} // namespace Check
+
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef DECISIONTREE_CONCURRENTBUILDBENCHMARK_H
+#define DECISIONTREE_CONCURRENTBUILDBENCHMARK_H
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <iostream>
+#include "../TreeBuilder/SingleTreeBuildDriver.h"
+#include "Check.h"
+#include "TreeBuildFixture.h"
+
+/// Throughput of N builds on the same dataset, one after another against all at once, each build with
+/// its own driver and workers. With every feature considered for a split the builds draw no random numbers,
+/// so every tree must come out the same as the first one built alone.
+class ConcurrentBuildBenchmark : public TreeBuildFixture {
+ public:
+  ConcurrentBuildBenchmark(uint32_t cost_function,
+                           uint32_t min_leaf_node,
+                           uint32_t min_split_node,
+                           uint32_t num_workers_per_build):
+    TreeBuildFixture(cost_function, min_leaf_node, min_split_node), num_workers_per_build(num_workers_per_build) {}
+
+  /// Run 1, 2, 4, ... up to max_num_builds builds
+  void Start(uint32_t max_num_builds) {
+    for (uint32_t num_builds = 1; num_builds <= max_num_builds; num_builds *= 2) {
+      double sequential_time = Time(num_builds, false);
+      double concurrent_time = Time(num_builds, true);
+      std::cout << "Builds: " << num_builds
+                << "  Sequential: " << num_builds / sequential_time << " trees/s"
+                << "  Concurrent: " << num_builds / concurrent_time << " trees/s" << std::endl;
+    }
+  }
+
+ private:
+  const uint32_t num_workers_per_build;
+
+  double Time(uint32_t num_builds,
+              bool concurrent) {
+    std::vector<std::unique_ptr<SingleTreeBuildDriver>> drivers;
+    std::vector<std::unique_ptr<StoredTree>> trees;
+    for (uint32_t idx = 0; idx != num_builds; ++idx) {
+      drivers.emplace_back(new SingleTreeBuildDriver(cost_function, min_leaf_node, min_split_node,
+                                                     dataset->Meta().num_features, idx, num_workers_per_build,
+                                                     UINT32_MAX, UINT32_MAX));
+      trees.emplace_back(MakeTree());
+      drivers[idx]->LoadDataset(dataset);
+      drivers[idx]->LoadTree(trees[idx].get());
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (concurrent) {
+      std::vector<std::thread> threads;
+      for (auto &driver: drivers)
+        threads.emplace_back(&SingleTreeBuildDriver::Build, driver.get());
+      for (auto &thread: threads)
+        thread.join();
+    } else {
+      for (auto &driver: drivers)
+        driver->Build();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    for (auto &tree: trees)
+      CHECK(TreeComparison::Equal(*tree, *trees[0]));
+    return elapsed.count();
+  }
+};
+
+#endif
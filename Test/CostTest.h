@@ -0,0 +1,24 @@
+
+#ifndef DECISIONTREE_COSTTEST_H
+#define DECISIONTREE_COSTTEST_H
+
+#include <cmath>
+#include <iostream>
+#include "../Global/GlobalConsts.h"
+#include "../Util/Cost.h"
+#include "Check.h"
+
+/// The cost of a histogram follows the cost function it is asked for, not the cost function of the last build
+/// that set the costs up: a Gini root has its cost even when no entropy build ran before it.
+class CostTest {
+ public:
+  void Start() {
+    const vec_dbl_t histogram = {3.0, 1.0};
+    CHECK(std::fabs(Cost::Cost(GiniImpurity, histogram) - 1.5) <= FloatError);
+    CHECK(std::fabs(Cost::Cost(Entropy, histogram) - (8.0 - 3.0 * log2(3.0))) <= FloatError);
+    CHECK(Cost::Cost(GiniImpurity, {4.0, 0.0}) <= FloatError);
+    std::cout << "Cost: Gini and entropy costs of a root" << std::endl;
+  }
+};
+
+#endif
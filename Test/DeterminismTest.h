@@ -0,0 +1,81 @@
+
+#ifndef DECISIONTREE_DETERMINISMTEST_H
+#define DECISIONTREE_DETERMINISMTEST_H
+
+#include <memory>
+#include <numeric>
+#include <iostream>
+#include "../TreeBuilder/SingleTreeBuildDriver.h"
+#include "../Util/Random.h"
+#include "Check.h"
+#include "TreeBuildFixture.h"
+
+/// A tree must not depend on the number of workers that built it: the same tree is built with 1, 2, ... num_threads
+/// workers and every build must match the first cell for cell and leaf for leaf. num_features_for_split should be
+/// below the number of features of the dataset, so that the feature draws are covered as well.
+class DeterminismTest : public TreeBuildFixture {
+ public:
+  DeterminismTest(uint32_t cost_function,
+                  uint32_t num_features_for_split,
+                  uint32_t min_leaf_node,
+                  uint32_t min_split_node,
+                  uint32_t random_state):
+    TreeBuildFixture(cost_function, min_leaf_node, min_split_node), num_features_for_split(num_features_for_split),
+    random_state(random_state) {}
+
+  void Start(uint32_t num_threads) {
+    CheckPhilox();
+    CheckBootstrap();
+    std::unique_ptr<StoredTree> expected = Build(1);
+    for (uint32_t num_workers = 2; num_workers <= num_threads; ++num_workers) {
+      std::unique_ptr<StoredTree> tree = Build(num_workers);
+      CHECK(TreeComparison::Equal(*tree, *expected));
+    }
+    std::cout << "Determinism: " << expected->num_cell << " cells alike for 1 to " << num_threads << " workers"
+              << std::endl;
+  }
+
+ private:
+  const uint32_t num_features_for_split;
+  const uint32_t random_state;
+
+  std::unique_ptr<StoredTree> Build(uint32_t num_workers) {
+    SingleTreeBuildDriver driver(cost_function, min_leaf_node, min_split_node, num_features_for_split, random_state,
+                                 num_workers, UINT32_MAX, UINT32_MAX);
+    std::unique_ptr<StoredTree> tree = MakeTree();
+    driver.LoadDataset(dataset);
+    driver.LoadTree(tree.get());
+    driver.Build();
+    return tree;
+  }
+
+  /// Known answers of Philox4x32-10 from the Random123 distribution
+  void CheckPhilox() {
+    const uint32_t keys[3][2] = {{0, 0}, {0xa4093822, 0x299f31d0}, {0xffffffff, 0xffffffff}};
+    const uint32_t counters[3][4] = {{0, 0, 0, 0}, {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                     {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}};
+    const uint32_t answers[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                                    {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1},
+                                    {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}};
+    for (uint32_t test_idx = 0; test_idx != 3; ++test_idx) {
+      uint32_t output[4];
+      Philox::Block(keys[test_idx], counters[test_idx], output);
+      for (uint32_t idx = 0; idx != 4; ++idx)
+        CHECK(output[idx] == answers[test_idx][idx]);
+    }
+  }
+
+  /// A stream drawn twice gives the same histogram, and a bootstrap keeps the number of samples
+  void CheckBootstrap() {
+    uint32_t n = dataset->Meta().size;
+    vec_uint8_t first(n, 0), second(n, 0);
+    Philox first_generator(random_state, Random::BootstrapStream);
+    Philox second_generator(random_state, Random::BootstrapStream);
+    Random::SampleWithReplacement(n, n, first.data(), first_generator);
+    Random::SampleWithReplacement(n, n, second.data(), second_generator);
+    CHECK(first == second);
+    CHECK(std::accumulate(first.begin(), first.end(), 0u) == n);
+  }
+};
+
+#endif
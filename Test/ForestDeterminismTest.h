@@ -0,0 +1,155 @@
+
+#ifndef DECISIONTREE_FORESTDETERMINISMTEST_H
+#define DECISIONTREE_FORESTDETERMINISMTEST_H
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <iostream>
+#include "../Dataset/Dataset.h"
+#include "../Trainer/ForestTrainer.h"
+#include "Check.h"
+#include "TreeComparison.h"
+
+/// The sums of a forest must not depend on the way it was trained: routing the samples out of the bag through the
+/// trees as they are built gives the same sums, sample for sample, as sending them down the finished trees. The trees
+/// are built one after another, so that every way adds to the sums in the same order. A forest warm started from
+/// some of its trees must end with the trees and sums of the forest trained in one go. Early stopping must stop at
+/// the first check that has a window of checks before it when the out-of-bag curve is flat, and under a finite
+/// tolerance at the first check whose drop over the window is below the tolerance. num_trees should be above the
+/// trees of the first check with a window, (window + 1) * num_trees_per_check.
+class ForestDeterminismTest {
+ public:
+  ForestDeterminismTest(uint32_t cost_function,
+                        uint32_t num_features_for_split,
+                        uint32_t min_leaf_node,
+                        uint32_t min_split_node,
+                        uint32_t random_state):
+    cost_function(cost_function), num_features_for_split(num_features_for_split), min_leaf_node(min_leaf_node),
+    min_split_node(min_split_node), random_state(random_state), dataset(nullptr) {}
+
+  void LoadDataset(Dataset *dataset) {
+    this->dataset = dataset;
+  }
+
+  void Start(uint32_t num_threads,
+             uint32_t num_trees) {
+    CheckRouting(num_threads, num_trees);
+    CheckWarmStart(num_threads, num_trees);
+    CheckEarlyStopping(num_threads, num_trees);
+    std::cout << "Forest Determinism: sums alike with and without routing, warm started and cold, "
+              << "early stopping on time" << std::endl;
+  }
+
+ private:
+  const uint32_t cost_function;
+  const uint32_t num_features_for_split;
+  const uint32_t min_leaf_node;
+  const uint32_t min_split_node;
+  const uint32_t random_state;
+  Dataset *dataset;
+
+  std::unique_ptr<ForestTrainer> MakeTrainer(uint32_t num_threads,
+                                             uint32_t num_trees) {
+    auto trainer = std::make_unique<ForestTrainer>(cost_function, num_features_for_split, min_leaf_node,
+                                                   min_split_node, UINT32_MAX, UINT32_MAX, random_state,
+                                                   num_threads, num_trees);
+    trainer->LoadData(dataset);
+    return trainer;
+  }
+
+  ForestTrainer::ForestState Train(uint32_t num_threads,
+                                   uint32_t num_trees,
+                                   bool route_out_of_bag) {
+    std::unique_ptr<ForestTrainer> trainer = MakeTrainer(num_threads, num_trees);
+    trainer->SetOutOfBagRouting(route_out_of_bag);
+    trainer->Train(false);
+    return trainer->ReleaseState();
+  }
+
+  static void AssertSameSums(const ForestTrainer::ForestState &x,
+                             const ForestTrainer::ForestState &y) {
+    CHECK(x.total_sample_weights == y.total_sample_weights);
+    CHECK(x.oob_count == y.oob_count);
+    CHECK(x.output_prob == y.output_prob);
+    CHECK(x.output_mean == y.output_mean);
+    CHECK(x.oob_output_prob == y.oob_output_prob);
+    CHECK(x.oob_output_mean == y.oob_output_mean);
+  }
+
+  void CheckRouting(uint32_t num_threads,
+                    uint32_t num_trees) {
+    ForestTrainer::ForestState sent_down = Train(num_threads, num_trees, false);
+    ForestTrainer::ForestState routed = Train(num_threads, num_trees, true);
+    AssertSameSums(sent_down, routed);
+  }
+
+  /// num_trees / 2 trees, then the rest on top of them
+  void CheckWarmStart(uint32_t num_threads,
+                      uint32_t num_trees) {
+    ForestTrainer::ForestState cold = Train(num_threads, num_trees, false);
+    ForestTrainer::ForestState kept = Train(num_threads, num_trees / 2, false);
+    std::unique_ptr<ForestTrainer> trainer = MakeTrainer(num_threads, num_trees - num_trees / 2);
+    trainer->WarmStart(std::move(kept));
+    trainer->Train(false);
+    ForestTrainer::ForestState warm = trainer->ReleaseState();
+    AssertSameSums(cold, warm);
+    CHECK(warm.trees.size() == cold.trees.size());
+    for (uint32_t tree_id = 0; tree_id != num_trees; ++tree_id)
+      CHECK(TreeComparison::Equal(*warm.trees[tree_id], *cold.trees[tree_id]));
+  }
+
+  /// Every curve is flat under an infinite tolerance, and none is under a tolerance of minus infinity
+  void CheckEarlyStopping(uint32_t num_threads,
+                          uint32_t num_trees) {
+    const uint32_t num_trees_per_check = 2;
+    const uint32_t window = 1;
+    for (double tolerance: {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()}) {
+      std::unique_ptr<ForestTrainer> trainer = MakeTrainer(num_threads, num_trees);
+      trainer->SetEarlyStopping(num_trees_per_check, window, tolerance);
+      trainer->Train(false);
+      uint32_t num_checks = (tolerance > 0.0)? window + 1 : num_trees / num_trees_per_check;
+      const auto &curve = trainer->OutOfBagCurve();
+      CHECK(curve.size() == num_checks);
+      for (uint32_t check_idx = 0; check_idx != num_checks; ++check_idx)
+        CHECK(curve[check_idx].num_trees == (check_idx + 1) * num_trees_per_check);
+      uint32_t num_built_trees = (tolerance > 0.0)? num_checks * num_trees_per_check : num_trees;
+      CHECK(trainer->ReleaseState().trees.size() == num_built_trees);
+    }
+    CheckFiniteTolerance(num_threads, num_trees);
+  }
+
+  /// The tolerance is taken from the curve of the whole forest, halfway between the drop over the window at the
+  /// first check that has a window and the first drop below it, so that the forest must stop at that later check.
+  /// If no drop is below the first one, it must stop at the first check that has a window.
+  void CheckFiniteTolerance(uint32_t num_threads,
+                            uint32_t num_trees) {
+    const uint32_t window = 2;
+    std::unique_ptr<ForestTrainer> full_trainer = MakeTrainer(num_threads, num_trees);
+    full_trainer->SetEarlyStopping(1, window, -std::numeric_limits<double>::infinity());
+    full_trainer->Train(false);
+    const auto &full_curve = full_trainer->OutOfBagCurve();
+    CHECK(full_curve.size() == num_trees);
+    vec_dbl_t drops;
+    for (uint32_t check_idx = window; check_idx != num_trees; ++check_idx)
+      drops.push_back(full_curve[check_idx - window].oob_error - full_curve[check_idx].oob_error);
+    auto stop = std::find_if(drops.begin() + 1, drops.end(), [&drops](double drop) {
+      return drop < drops[0];
+    });
+    double tolerance = (stop != drops.end())? (drops[0] + *stop) / 2.0 : drops[0] + 1.0;
+    if (stop == drops.end())
+      stop = drops.begin();
+    auto num_checks = static_cast<uint32_t>(window + (stop - drops.begin()) + 1);
+
+    std::unique_ptr<ForestTrainer> trainer = MakeTrainer(num_threads, num_trees);
+    trainer->SetEarlyStopping(1, window, tolerance);
+    trainer->Train(false);
+    const auto &curve = trainer->OutOfBagCurve();
+    CHECK(curve.size() == num_checks);
+    for (uint32_t check_idx = 0; check_idx != num_checks; ++check_idx)
+      CHECK(curve[check_idx].oob_error == full_curve[check_idx].oob_error);
+    CHECK(trainer->ReleaseState().trees.size() == num_checks);
+  }
+};
+
+#endif
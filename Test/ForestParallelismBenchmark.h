@@ -0,0 +1,61 @@
+
+#ifndef DECISIONTREE_FORESTPARALLELISMBENCHMARK_H
+#define DECISIONTREE_FORESTPARALLELISMBENCHMARK_H
+
+#include <chrono>
+#include <iostream>
+#include "../Dataset/Dataset.h"
+#include "../Trainer/ForestTrainer.h"
+
+/// Forest throughput for one thread budget split between trees and the workers of each tree: node-parallel,
+/// one tree at a time with all threads, tree-parallel, one thread for each of as many trees at once,
+/// the hybrids in between, and the adaptive schedule, which moves all threads between trees as it goes.
+class ForestParallelismBenchmark {
+ public:
+  ForestParallelismBenchmark(uint32_t cost_function,
+                             uint32_t num_features_for_split,
+                             uint32_t min_leaf_node,
+                             uint32_t min_split_node,
+                             uint32_t num_trees):
+    cost_function(cost_function), num_features_for_split(num_features_for_split), min_leaf_node(min_leaf_node),
+    min_split_node(min_split_node), num_trees(num_trees), dataset(nullptr) {}
+
+  void LoadDataset(Dataset *dataset) {
+    this->dataset = dataset;
+  }
+
+  /// num_threads is split as num_threads / k workers for each of k trees at once, k = 1, 2, 4, ... num_threads
+  void Start(uint32_t num_threads) {
+    for (uint32_t num_concurrent_trees = 1; num_concurrent_trees <= num_threads; num_concurrent_trees *= 2) {
+      uint32_t num_workers = num_threads / num_concurrent_trees;
+      double elapsed = Time(num_workers, num_concurrent_trees);
+      std::cout << "Trees at Once: " << num_concurrent_trees << "  Workers per Tree: " << num_workers
+                << "  Throughput: " << num_trees / elapsed << " trees/s" << std::endl;
+    }
+    double elapsed = Time(num_threads, AdaptiveTreeParallelism);
+    std::cout << "Adaptive  Workers: " << num_threads << "  Throughput: " << num_trees / elapsed << " trees/s"
+              << std::endl;
+  }
+
+ private:
+  const uint32_t cost_function;
+  const uint32_t num_features_for_split;
+  const uint32_t min_leaf_node;
+  const uint32_t min_split_node;
+  const uint32_t num_trees;
+  Dataset *dataset;
+
+  double Time(uint32_t num_workers,
+              uint32_t num_concurrent_trees) {
+    ForestTrainer trainer(cost_function, num_features_for_split, min_leaf_node, min_split_node, UINT32_MAX,
+                          UINT32_MAX, 0, num_workers, num_trees);
+    trainer.LoadData(dataset);
+    trainer.SetTreeParallelism(num_concurrent_trees);
+    auto start = std::chrono::steady_clock::now();
+    trainer.Train(false);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+};
+
+#endif
@@ -0,0 +1,95 @@
+
+#ifndef DECISIONTREE_JOBQUEUEBENCHMARK_H
+#define DECISIONTREE_JOBQUEUEBENCHMARK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include "../Parallel/Job.h"
+#include "../Parallel/JobQueue.h"
+#include "../Parallel/LockFreeSkipList.h"
+#include "Check.h"
+
+/// Throughput of the job queue against a single skip list shared by all workers, which is what the job queue
+/// was before it had worker deques. Each job of the workload spins for a while and spawns two jobs,
+/// the same fork-join shape as splitting tree nodes.
+class JobQueueBenchmark {
+ public:
+  JobQueueBenchmark(uint32_t num_jobs,
+                    uint32_t work_per_job):
+    num_jobs(num_jobs), work_per_job(work_per_job), num_done(0), finished(false), skip_list(), jobs() {}
+
+  /// Run both queues with 1, 2, 4, ... up to max_num_threads workers
+  void Start(uint32_t max_num_threads) {
+    for (uint32_t num_threads = 1; num_threads <= max_num_threads; num_threads *= 2) {
+      double skip_list_time = Time(num_threads, &JobQueueBenchmark::RunSkipList);
+      double job_queue_time = Time(num_threads, &JobQueueBenchmark::RunJobQueue);
+      std::cout << "Threads: " << num_threads
+                << "  Skip List: " << num_jobs / skip_list_time << " jobs/s"
+                << "  Job Queue: " << num_jobs / job_queue_time << " jobs/s"
+                << "  Idle: " << jobs.SpinTime() << " s spinning, " << jobs.ParkedTime() << " s parked" << std::endl;
+    }
+  }
+
+ private:
+  const uint32_t num_jobs;
+  const uint32_t work_per_job;
+  std::atomic<uint32_t> num_done;
+  std::atomic<bool> finished;
+  LockFreeSkipList<Job> skip_list;
+  JobQueue<Job> jobs;
+
+  double Time(uint32_t num_threads,
+              void (JobQueueBenchmark::*run)(uint32_t)) {
+    num_done = 0;
+    finished = false;
+    jobs.Init(num_threads);
+    jobs.Offer(Job::WriteToTreeJob(0));
+    skip_list.Insert(Job::WriteToTreeJob(0));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t idx = 0; idx != num_threads; ++idx)
+      threads.emplace_back(run, this, idx);
+    for (auto &thread: threads)
+      thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(num_done == num_jobs);
+    return elapsed.count();
+  }
+
+  /// Return whether this was the last job
+  bool Work() {
+    std::atomic<uint32_t> sink(0);
+    for (uint32_t idx = 0; idx != work_per_job; ++idx)
+      sink.fetch_add(idx, std::memory_order_relaxed);
+    return ++num_done == num_jobs;
+  }
+
+  void RunSkipList(uint32_t) {
+    Job job = Job::IdleJob();
+    // jobs are numbered as the nodes of a complete binary tree, job id spawns 2 id + 1 and 2 id + 2
+    while (!finished) {
+      if (!skip_list.Poll(job))
+        continue;
+      uint32_t job_id = job.tree_id;
+      for (uint32_t child_id = 2 * job_id + 1; child_id <= 2 * job_id + 2 && child_id < num_jobs; ++child_id)
+        skip_list.Insert(Job::WriteToTreeJob(child_id));
+      if (Work())
+        finished = true;
+    }
+  }
+
+  void RunJobQueue(uint32_t worker_idx) {
+    Job job = Job::IdleJob();
+    while (!jobs.Poll(worker_idx, job)) {
+      uint32_t job_id = job.tree_id;
+      for (uint32_t child_id = 2 * job_id + 1; child_id <= 2 * job_id + 2 && child_id < num_jobs; ++child_id)
+        jobs.Push(worker_idx, Job::WriteToTreeJob(child_id));
+      if (Work())
+        jobs.SetFinish();
+    }
+  }
+};
+
+#endif
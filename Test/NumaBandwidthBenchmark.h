@@ -0,0 +1,76 @@
+
+#ifndef DECISIONTREE_NUMABANDWIDTHBENCHMARK_H
+#define DECISIONTREE_NUMABANDWIDTHBENCHMARK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include "../Generics/TypeDefs.h"
+#include "../Util/Numa.h"
+
+/// Read bandwidth of each socket, with one thread on every CPU of the node, from memory on each node and from
+/// memory interleaved across all nodes. The gap between the local and the remote columns is what a build pays
+/// on every gather and partition when the features sit on another node.
+class NumaBandwidthBenchmark {
+ public:
+  NumaBandwidthBenchmark(uint32_t num_megabytes,
+                         uint32_t num_passes):
+    num_words(num_megabytes * (1u << 20) / sizeof(uint64_t)), num_passes(num_passes), sink(0) {}
+
+  void Start() {
+    uint32_t num_nodes = Numa::NumNodes();
+    std::cout << "Nodes: " << num_nodes << std::endl;
+    for (uint32_t cpu_node = 0; cpu_node != num_nodes; ++cpu_node) {
+      std::cout << "Socket " << cpu_node << ":";
+      for (uint32_t memory_node = 0; memory_node != num_nodes; ++memory_node) {
+        std::vector<uint64_t> words;
+        Numa::RunOnNode(memory_node, [this, &words]() {
+          words.assign(num_words, 1);
+        });
+        std::cout << "  Node " << memory_node << " (on node " << Numa::NodeOfAddress(words.data() + num_words / 2)
+                  << "): " << Bandwidth(cpu_node, words) << " GB/s";
+      }
+      std::vector<uint64_t> words(num_words, 1);
+      Numa::Interleave(words.data(), words.size() * sizeof(uint64_t));
+      std::cout << "  Interleaved: " << Bandwidth(cpu_node, words) << " GB/s" << std::endl;
+    }
+  }
+
+ private:
+  const uint32_t num_words;
+  const uint32_t num_passes;
+  std::atomic<uint64_t> sink;
+
+  double Bandwidth(uint32_t cpu_node,
+                   const std::vector<uint64_t> &words) {
+    const vec_uint32_t &cpus = Numa::NodeCpus(cpu_node);
+    auto num_threads = static_cast<uint32_t>(cpus.size());
+    uint32_t block_size = num_words / num_threads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t thread_idx = 0; thread_idx != num_threads; ++thread_idx) {
+      uint32_t begin = thread_idx * block_size;
+      uint32_t end = (thread_idx == num_threads - 1)? num_words : begin + block_size;
+      threads.emplace_back(&NumaBandwidthBenchmark::Read, this, std::cref(words), begin, end);
+      Numa::PinToCpu(threads.back(), cpus[thread_idx]);
+    }
+    for (auto &thread: threads)
+      thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return 1e-9 * num_passes * num_words * sizeof(uint64_t) / elapsed.count();
+  }
+
+  void Read(const std::vector<uint64_t> &words,
+            uint32_t begin,
+            uint32_t end) {
+    uint64_t sum = 0;
+    for (uint32_t pass = 0; pass != num_passes; ++pass)
+      for (uint32_t idx = begin; idx != end; ++idx)
+        sum += words[idx];
+    sink += sum;
+  }
+};
+
+#endif
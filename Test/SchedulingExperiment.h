@@ -0,0 +1,64 @@
+
+#ifndef DECISIONTREE_SCHEDULINGEXPERIMENT_H
+#define DECISIONTREE_SCHEDULINGEXPERIMENT_H
+
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include "../TreeBuilder/SingleTreeBuildDriver.h"
+#include "Check.h"
+#include "TreeBuildFixture.h"
+
+/// Makespan of one tree build under each scheduling policy, and the utilization of its workers: the share of
+/// worker time not spent looking for a job. Every policy must grow the same tree.
+class SchedulingExperiment : public TreeBuildFixture {
+ public:
+  SchedulingExperiment(uint32_t cost_function,
+                       uint32_t min_leaf_node,
+                       uint32_t min_split_node,
+                       uint32_t max_depth,
+                       uint32_t num_workers):
+    TreeBuildFixture(cost_function, min_leaf_node, min_split_node), max_depth(max_depth), num_workers(num_workers),
+    first_tree() {}
+
+  void Start(uint32_t num_repeats) {
+    first_tree.reset();
+    Report("Local First", LocalFirst, num_repeats);
+    Report("Largest Subset First", LargestSubsetFirst, num_repeats);
+    Report("Estimated Work First", EstimatedWorkFirst, num_repeats);
+  }
+
+ private:
+  const uint32_t max_depth;
+  const uint32_t num_workers;
+  std::unique_ptr<StoredTree> first_tree;
+
+  void Report(const char *name,
+              uint32_t policy_id,
+              uint32_t num_repeats) {
+    double makespan = 0.0, idle_time = 0.0;
+    for (uint32_t repeat = 0; repeat != num_repeats; ++repeat) {
+      SingleTreeBuildDriver driver(cost_function, min_leaf_node, min_split_node, dataset->Meta().num_features, 0,
+                                   num_workers, UINT32_MAX, max_depth);
+      std::unique_ptr<StoredTree> tree = MakeTree();
+      driver.SetSchedulingPolicy(policy_id);
+      driver.LoadDataset(dataset);
+      driver.LoadTree(tree.get());
+      auto start = std::chrono::steady_clock::now();
+      driver.Build();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      makespan += elapsed.count();
+      idle_time += tree->spin_time + tree->parked_time;
+      if (!first_tree)
+        first_tree = std::move(tree);
+      else
+        CHECK(TreeComparison::Equal(*tree, *first_tree));
+    }
+    makespan /= num_repeats;
+    idle_time /= num_repeats;
+    std::cout << name << "  Makespan: " << makespan << " second(s)"
+              << "  Utilization: " << 100.0 * (1.0 - idle_time / (makespan * num_workers)) << "%" << std::endl;
+  }
+};
+
+#endif
@@ -0,0 +1,62 @@
+
+#ifndef DECISIONTREE_SKIPLISTSOAKBENCHMARK_H
+#define DECISIONTREE_SKIPLISTSOAKBENCHMARK_H
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <iostream>
+#include <unistd.h>
+#include "../Parallel/Job.h"
+#include "../Parallel/LockFreeSkipList.h"
+#include "Check.h"
+
+/// Memory of a skip list that lives across many rounds, each round standing for one tree:
+/// new threads insert and poll a batch of jobs, then exit. The resident set should stay flat.
+class SkipListSoakBenchmark {
+ public:
+  explicit SkipListSoakBenchmark(uint32_t num_jobs_per_thread):
+    num_jobs_per_thread(num_jobs_per_thread), list(), num_taken(0) {}
+
+  void Start(uint32_t num_rounds,
+             uint32_t num_threads,
+             uint32_t report_every) {
+    for (uint32_t round = 0; round != num_rounds; ++round) {
+      num_taken = 0;
+      std::vector<std::thread> threads;
+      for (uint32_t idx = 0; idx != num_threads; ++idx)
+        threads.emplace_back(&SkipListSoakBenchmark::Run, this, round * num_threads + idx);
+      for (auto &thread: threads)
+        thread.join();
+      CHECK(num_taken == num_threads * num_jobs_per_thread);
+      if ((round + 1) % report_every == 0)
+        std::cout << "Round: " << round + 1 << "  Resident: " << ResidentKB() << " KB" << std::endl;
+    }
+  }
+
+ private:
+  const uint32_t num_jobs_per_thread;
+  LockFreeSkipList<Job> list;
+  std::atomic<uint32_t> num_taken;
+
+  void Run(uint32_t thread_id) {
+    for (uint32_t idx = 0; idx != num_jobs_per_thread; ++idx) {
+      bool inserted = list.Insert(Job::WriteToTreeJob(thread_id * num_jobs_per_thread + idx));
+      CHECK(inserted);
+    }
+    Job job = Job::IdleJob();
+    for (uint32_t idx = 0; idx != num_jobs_per_thread; ++idx) {
+      while (!list.Poll(job));
+      ++num_taken;
+    }
+  }
+
+  static uint64_t ResidentKB() {
+    uint64_t size = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+  }
+};
+
+#endif
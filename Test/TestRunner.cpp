@@ -0,0 +1,65 @@
+
+#include <cstdint>
+#include <iostream>
+#include "ConcurrentBuildBenchmark.h"
+#include "CostTest.h"
+#include "DeterminismTest.h"
+#include "ForestDeterminismTest.h"
+#include "ForestParallelismBenchmark.h"
+#include "JobQueueBenchmark.h"
+#include "NumaBandwidthBenchmark.h"
+#include "RandomDataset.h"
+#include "SchedulingExperiment.h"
+#include "SkipListSoakBenchmark.h"
+#include "ThreadPoolBenchmark.h"
+#include "TraceOverheadBenchmark.h"
+
+/// Runs every test, and every benchmark on a workload small enough to take seconds, so that the checks of the
+/// benchmarks run as well. A failed check aborts the run.
+int main() {
+  const uint32_t num_threads = 4;
+
+  CostTest cost_test;
+  cost_test.Start();
+
+  RandomDataset<float, uint32_t, uint32_t> classification;
+  classification.RandomMixedDataset(20000, 10, 5, 5, 5, 10, 40, 10, 40, 5, 8, 4);
+  RandomDataset<float, uint32_t, double> regression;
+  regression.RandomMixedRegDataset(20000, 10, 5, 5, 5, 10, 20, 10, 20, 5, 12);
+
+  for (uint32_t cost_function: {GiniImpurity, Entropy, Variance}) {
+    Dataset *dataset = (cost_function == Variance)? regression.dataset.get() : classification.dataset.get();
+    DeterminismTest determinism_test(cost_function, 6, 1, 2, 7);
+    determinism_test.LoadDataset(dataset);
+    determinism_test.Start(num_threads);
+    ForestDeterminismTest forest_determinism_test(cost_function, 6, 1, 2, 7);
+    forest_determinism_test.LoadDataset(dataset);
+    forest_determinism_test.Start(num_threads, 6);
+  }
+
+  Dataset *dataset = classification.dataset.get();
+  ConcurrentBuildBenchmark concurrent_build_benchmark(GiniImpurity, 1, 2, 2);
+  concurrent_build_benchmark.LoadDataset(dataset);
+  concurrent_build_benchmark.Start(num_threads);
+  SchedulingExperiment scheduling_experiment(GiniImpurity, 1, 2, UINT32_MAX, num_threads);
+  scheduling_experiment.LoadDataset(dataset);
+  scheduling_experiment.Start(1);
+  TraceOverheadBenchmark trace_overhead_benchmark(GiniImpurity, 1, 2, UINT32_MAX, num_threads);
+  trace_overhead_benchmark.LoadDataset(dataset);
+  trace_overhead_benchmark.Start(1);
+  ForestParallelismBenchmark forest_parallelism_benchmark(GiniImpurity, 6, 1, 2, 8);
+  forest_parallelism_benchmark.LoadDataset(dataset);
+  forest_parallelism_benchmark.Start(num_threads);
+
+  JobQueueBenchmark job_queue_benchmark(100000, 100);
+  job_queue_benchmark.Start(num_threads);
+  SkipListSoakBenchmark skip_list_soak_benchmark(10000);
+  skip_list_soak_benchmark.Start(20, num_threads, 10);
+  ThreadPoolBenchmark thread_pool_benchmark(1000);
+  thread_pool_benchmark.Start(num_threads);
+  NumaBandwidthBenchmark numa_bandwidth_benchmark(64, 2);
+  numa_bandwidth_benchmark.Start();
+
+  std::cout << "All checks passed" << std::endl;
+  return 0;
+}
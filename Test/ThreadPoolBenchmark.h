@@ -0,0 +1,65 @@
+
+#ifndef DECISIONTREE_THREADPOOLBENCHMARK_H
+#define DECISIONTREE_THREADPOOLBENCHMARK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include "../Parallel/ThreadPool.h"
+#include "Check.h"
+
+/// Cost of starting the workers of one tree build or one batch prediction, which is all that changes between
+/// threads created per call and the thread pool. Each round starts num_threads tasks that do almost nothing
+/// and waits for them, as many rounds as there would be builds and predictions in a forest.
+class ThreadPoolBenchmark {
+ public:
+  explicit ThreadPoolBenchmark(uint32_t num_rounds):
+    num_rounds(num_rounds), num_done(0) {}
+
+  /// Run both with 1, 2, 4, ... up to max_num_threads threads per round
+  void Start(uint32_t max_num_threads) {
+    for (uint32_t num_threads = 1; num_threads <= max_num_threads; num_threads *= 2) {
+      double thread_time = Time(num_threads, &ThreadPoolBenchmark::RunThreads);
+      double pool_time = Time(num_threads, &ThreadPoolBenchmark::RunPool);
+      std::cout << "Threads: " << num_threads
+                << "  New Threads: " << thread_time / num_rounds * 1e6 << " us/round"
+                << "  Thread Pool: " << pool_time / num_rounds * 1e6 << " us/round" << std::endl;
+    }
+  }
+
+ private:
+  const uint32_t num_rounds;
+  std::atomic<uint32_t> num_done;
+
+  double Time(uint32_t num_threads,
+              void (ThreadPoolBenchmark::*run)(uint32_t)) {
+    num_done = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round != num_rounds; ++round)
+      (this->*run)(num_threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(num_done == num_rounds * num_threads);
+    return elapsed.count();
+  }
+
+  void Task(uint32_t) {
+    ++num_done;
+  }
+
+  void RunThreads(uint32_t num_threads) {
+    std::vector<std::thread> threads;
+    for (uint32_t idx = 0; idx != num_threads; ++idx)
+      threads.emplace_back(&ThreadPoolBenchmark::Task, this, idx);
+    for (auto &thread: threads)
+      thread.join();
+  }
+
+  void RunPool(uint32_t num_threads) {
+    ThreadPool::GetInstance().Run(num_threads, [this](uint32_t task_idx) {
+      Task(task_idx);
+    });
+  }
+};
+
+#endif
@@ -0,0 +1,67 @@
+
+#ifndef DECISIONTREE_TRACEOVERHEADBENCHMARK_H
+#define DECISIONTREE_TRACEOVERHEADBENCHMARK_H
+
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include "../TreeBuilder/SingleTreeBuildDriver.h"
+#include "Check.h"
+#include "TreeBuildFixture.h"
+
+/// Build time of one tree with tracing off and on, the builds alternate so that both see the same machine state.
+/// Tracing must not change the tree. The trace of the last build is written to trace_path if one is given.
+class TraceOverheadBenchmark : public TreeBuildFixture {
+ public:
+  TraceOverheadBenchmark(uint32_t cost_function,
+                         uint32_t min_leaf_node,
+                         uint32_t min_split_node,
+                         uint32_t max_depth,
+                         uint32_t num_workers):
+    TreeBuildFixture(cost_function, min_leaf_node, min_split_node), max_depth(max_depth), num_workers(num_workers),
+    first_tree() {}
+
+  void Start(uint32_t num_repeats,
+             const char *trace_path = nullptr) {
+    first_tree.reset();
+    double off_time = 0.0, on_time = 0.0;
+    for (uint32_t repeat = 0; repeat != num_repeats; ++repeat) {
+      off_time += Time(false, nullptr);
+      on_time += Time(true, (repeat == num_repeats - 1)? trace_path : nullptr);
+    }
+    off_time /= num_repeats;
+    on_time /= num_repeats;
+    std::cout << "Tracing Off: " << off_time << " second(s)  Tracing On: " << on_time << " second(s)"
+              << "  Overhead: " << 100.0 * (on_time / off_time - 1.0) << "%" << std::endl;
+  }
+
+ private:
+  const uint32_t max_depth;
+  const uint32_t num_workers;
+  std::unique_ptr<StoredTree> first_tree;
+
+  double Time(bool tracing,
+              const char *trace_path) {
+    SingleTreeBuildDriver driver(cost_function, min_leaf_node, min_split_node, dataset->Meta().num_features, 0,
+                                 num_workers, UINT32_MAX, max_depth);
+    std::unique_ptr<StoredTree> tree = MakeTree();
+    driver.SetTracing(tracing);
+    driver.LoadDataset(dataset);
+    driver.LoadTree(tree.get());
+    auto start = std::chrono::steady_clock::now();
+    driver.Build();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!first_tree)
+      first_tree = std::move(tree);
+    else
+      CHECK(TreeComparison::Equal(*tree, *first_tree));
+    if (trace_path) {
+      std::ofstream out(trace_path);
+      driver.WriteTrace(out);
+    }
+    return elapsed.count();
+  }
+};
+
+#endif
@@ -0,0 +1,37 @@
+
+#ifndef DECISIONTREE_TREEBUILDFIXTURE_H
+#define DECISIONTREE_TREEBUILDFIXTURE_H
+
+#include <memory>
+#include "../Dataset/Dataset.h"
+#include "../Tree/StoredTree.h"
+#include "TreeComparison.h"
+
+/// What the tests and benchmarks that build single trees share: the parameters every build takes, the dataset,
+/// and an empty stored tree of the kind the cost function grows
+class TreeBuildFixture {
+ public:
+  TreeBuildFixture(uint32_t cost_function,
+                   uint32_t min_leaf_node,
+                   uint32_t min_split_node):
+    cost_function(cost_function), min_leaf_node(min_leaf_node), min_split_node(min_split_node), dataset(nullptr) {}
+
+  /// The dataset should already have its sample weights
+  void LoadDataset(const Dataset *dataset) {
+    this->dataset = dataset;
+  }
+
+ protected:
+  const uint32_t cost_function;
+  const uint32_t min_leaf_node;
+  const uint32_t min_split_node;
+  const Dataset *dataset;
+
+  std::unique_ptr<StoredTree> MakeTree() const {
+    if (cost_function == Variance)
+      return std::make_unique<RegressionStoredTree>();
+    return std::make_unique<ClassificationStoredTree>();
+  }
+};
+
+#endif
@@ -0,0 +1,31 @@
+
+#ifndef DECISIONTREE_TREECOMPARISON_H
+#define DECISIONTREE_TREECOMPARISON_H
+
+#include "../Tree/StoredTree.h"
+
+/// Two stored trees are the same if they agree cell by cell, on the type, children, split and bitmask of each cell,
+/// and leaf by leaf, on the probabilities or the mean of each leaf
+class TreeComparison {
+ public:
+  static bool Equal(const StoredTree &x,
+                    const StoredTree &y) {
+    if (x.num_cell != y.num_cell || x.num_leaf != y.num_leaf || x.cell_type != y.cell_type || x.left != y.left ||
+        x.right != y.right || x.bitmasks != y.bitmasks)
+      return false;
+    for (uint32_t cell_id = 0; cell_id != x.num_cell; ++cell_id)
+      if (x.cell_info[cell_id].integer != y.cell_info[cell_id].integer)
+        return false;
+    const auto *class_x = dynamic_cast<const ClassificationStoredTree *>(&x);
+    const auto *class_y = dynamic_cast<const ClassificationStoredTree *>(&y);
+    if (class_x && class_y)
+      return class_x->leaf_probability == class_y->leaf_probability;
+    const auto *regress_x = dynamic_cast<const RegressionStoredTree *>(&x);
+    const auto *regress_y = dynamic_cast<const RegressionStoredTree *>(&y);
+    if (regress_x && regress_y)
+      return regress_x->leaf_mean == regress_y->leaf_mean;
+    return false;
+  }
+};
+
+#endif
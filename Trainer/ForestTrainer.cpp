@@ -1,9 +1,14 @@
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <limits>
+#include <mutex>
 #include "ForestTrainer.h"
 #include "../Predictor/TreePredictor.h"
 #include "../Tree/StoredTree.h"
+#include "../Parallel/ThreadPool.h"
+#include "../TreeBuilder/ForestBuildDriver.h"
 #include "../Util/Random.h"
 #include "../Util/Maths.h"
 
@@ -13,40 +18,113 @@ void ForestTrainer::LoadData(Dataset *dataset) {
   total_sample_weights.resize(dataset->Meta().size, 0);
   oob_count.resize(dataset->Meta().size, 0);
   if (cost_function == GiniImpurity || cost_function == Entropy) {
-    output_prob.resize(dataset->Meta().size, vec_dbl_t(dataset->Meta().num_classes, 0.0));
-    oob_output_prob.resize(dataset->Meta().size, vec_dbl_t(dataset->Meta().num_classes, 0.0));
+    output_prob.resize(static_cast<size_t>(dataset->Meta().size) * dataset->Meta().num_classes, 0.0);
+    oob_output_prob.resize(output_prob.size(), 0.0);
   } else {
     output_mean.resize(dataset->Meta().size, 0.0);
     oob_output_mean.resize(dataset->Meta().size, 0.0);
   }
   feature_importance.resize(dataset->Meta().num_features, 0.0);
+  num_output_ranges = (dataset->Meta().size + NumSamplesPerOutputRange - 1) / NumSamplesPerOutputRange;
+  output_range_muts = std::make_unique<std::mutex[]>(num_output_ranges);
+}
+
+void ForestTrainer::SetNumaOptions(uint32_t numa_options) {
+  this->numa_options = numa_options;
+  for (auto &trainer: tree_trainers)
+    trainer->SetNumaOptions(numa_options);
+}
+
+void ForestTrainer::SetSchedulingPolicy(uint32_t policy_id) {
+  this->policy_id = policy_id;
+  for (auto &trainer: tree_trainers)
+    trainer->SetSchedulingPolicy(policy_id);
+}
+
+void ForestTrainer::SetTreeParallelism(uint32_t num_concurrent_trees) {
+  this->num_concurrent_trees = num_concurrent_trees;
+}
+
+void ForestTrainer::SetBootstrapMode(uint32_t bootstrap_mode) {
+  this->bootstrap_mode = bootstrap_mode;
+}
+
+void ForestTrainer::SetOutOfBagRouting(bool route_out_of_bag) {
+  this->route_out_of_bag = route_out_of_bag;
+}
+
+void ForestTrainer::SetEarlyStopping(uint32_t num_trees_per_check,
+                                     uint32_t window,
+                                     double tolerance) {
+  this->num_trees_per_check = num_trees_per_check;
+  stopping_window = window;
+  stopping_tolerance = tolerance;
+}
+
+const std::vector<ForestTrainer::OutOfBagCheck> &ForestTrainer::OutOfBagCurve() const {
+  return oob_curve;
+}
+
+/// Kept trees get trainers that are done, the trees still to build get trainers seeded by their place in the forest
+void ForestTrainer::WarmStart(ForestState &&state) {
+  assert(state.total_sample_weights.size() == dataset->Meta().size);
+  first_tree_id = static_cast<uint32_t>(state.trees.size());
+  std::vector<std::unique_ptr<TreeTrainer>> trainers;
+  trainers.reserve(first_tree_id + num_trees);
+  for (uint32_t tree_id = 0; tree_id != first_tree_id; ++tree_id) {
+    trainers.emplace_back(MakeTreeTrainer(tree_id));
+    trainers.back()->LoadData(dataset);
+    trainers.back()->tree = std::move(state.trees[tree_id]);
+    trainers.back()->ReadTree();
+    trainers.back()->ClearBuilder();
+  }
+  for (uint32_t tree_id = first_tree_id; tree_id != first_tree_id + num_trees; ++tree_id)
+    trainers.emplace_back(MakeTreeTrainer(tree_id));
+  tree_trainers = std::move(trainers);
+  total_sample_weights = std::move(state.total_sample_weights);
+  oob_count = std::move(state.oob_count);
+  output_prob = std::move(state.output_prob);
+  output_mean = std::move(state.output_mean);
+  oob_output_prob = std::move(state.oob_output_prob);
+  oob_output_mean = std::move(state.oob_output_mean);
+  presorted_indices = std::move(state.presorted_indices);
+}
+
+ForestTrainer::ForestState ForestTrainer::ReleaseState() {
+  ForestState state;
+  for (auto &trainer: tree_trainers)
+    state.trees.emplace_back(std::move(trainer->tree));
+  tree_trainers.clear();
+  first_tree_id = 0;
+  state.total_sample_weights = std::move(total_sample_weights);
+  state.oob_count = std::move(oob_count);
+  state.output_prob = std::move(output_prob);
+  state.output_mean = std::move(output_mean);
+  state.oob_output_prob = std::move(oob_output_prob);
+  state.oob_output_mean = std::move(oob_output_mean);
+  state.presorted_indices = std::move(presorted_indices);
+  return state;
 }
 
 void ForestTrainer::Train(bool to_report) {
   auto begin = std::chrono::high_resolution_clock::now();
+  num_trees_done = 0;
+  oob_curve.clear();
   Presort();
-  for (uint32_t tree_id = 0; tree_id < num_trees; ++tree_id) {
-    if (tree_id % 10 == 0)
-      std::cout << std::endl << "training tree: " << tree_id + 1;
-    std::cout << "." << std::flush;
-    TreeTrainer &trainer = *tree_trainers[tree_id];
-    trainer.LoadData(dataset);
-    vec_uint32_t sample_weights = Bootstrap(dataset->Meta().size);
-    for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx)
-      if (sample_weights[idx] == 0) {
-        ++oob_count[idx];
-      } else {
-        total_sample_weights[idx] += sample_weights[idx];
-      }
-    trainer.LoadSampleWeights(std::move(sample_weights));
-    trainer.Train(false);
-    trainer.Predict(false, true);
-    Accumulate(tree_id);
-    trainer.ClearOutput();
-    trainer.ClearBuilder();
+  // placed once up front, the trees only read the dataset
+  dataset->PlaceFeatures(numa_options);
+  double driver_spin_time = 0.0, driver_parked_time = 0.0;
+  if (num_concurrent_trees == AdaptiveTreeParallelism) {
+    TrainAdaptively(driver_spin_time, driver_parked_time);
+  } else {
+    TrainInTurns();
   }
+  // trees that were never started after an early stop are dropped
+  tree_trainers.resize(first_tree_id + num_trees);
   std::cout << std::endl;
   Reduce();
+  spin_time += driver_spin_time;
+  parked_time += driver_parked_time;
   auto end = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> time_duration = end - begin;
   training_time = time_duration.count();
@@ -56,6 +134,75 @@ void ForestTrainer::Train(bool to_report) {
   }
 }
 
+/// Trees are handed out in order, each task draws the bootstrap of its tree outside the lock
+void ForestTrainer::TrainInTurns() {
+  // every tree gets all of its workers, a build never waits for a thread held by another tree
+  uint32_t num_tree_tasks = std::min(num_concurrent_trees, num_trees);
+  ThreadPool::GetInstance().Reserve(std::max(num_tree_tasks * num_threads, 1u) - 1);
+  std::mutex next_mut;
+  uint32_t next_tree_id = first_tree_id;
+  uint32_t num_trees_to_build = first_tree_id + num_trees;
+  ThreadPool::GetInstance().Run(num_tree_tasks, [&](uint32_t) {
+    while (true) {
+      uint32_t tree_id;
+      vec_uint8_t sample_weights;
+      {
+        std::lock_guard<std::mutex> lock(next_mut);
+        if (next_tree_id == num_trees_to_build)
+          return;
+        tree_id = next_tree_id++;
+        if (tree_id % 10 == 0)
+          std::cout << std::endl << "training tree: " << tree_id + 1;
+        std::cout << "." << std::flush;
+      }
+      sample_weights = Bootstrap(tree_id, dataset->Meta().size);
+      if (TrainTree(tree_id, std::move(sample_weights))) {
+        std::lock_guard<std::mutex> lock(next_mut);
+        num_trees_to_build = next_tree_id;
+      }
+    }
+  });
+  num_trees = next_tree_id - first_tree_id;
+}
+
+void ForestTrainer::TrainAdaptively(double &driver_spin_time,
+                                    double &driver_parked_time) {
+  if (numa_options & NumaPinWorkers)
+    ThreadPool::GetInstance().Reserve(0, true);
+  // the driver numbers its trees from 0, seeded after the kept trees
+  ForestBuildDriver driver(TreeParams(params.cost_function, params.min_leaf_node, params.min_split_node,
+                                      params.max_depth, params.max_num_nodes, params.num_features_for_split,
+                                      params.random_state + first_tree_id),
+                           num_threads);
+  driver.LoadDataset(dataset);
+  driver.SetSchedulingPolicy(policy_id);
+  driver.LoadTrees(num_trees,
+                   [this](uint32_t driver_tree_id) {
+                     uint32_t tree_id = first_tree_id + driver_tree_id;
+                     if (tree_id % 10 == 0)
+                       std::cout << std::endl << "training tree: " << tree_id + 1;
+                     std::cout << "." << std::flush;
+                     TreeTrainer &trainer = *tree_trainers[tree_id];
+                     trainer.LoadData(dataset);
+                     trainer.LoadSampleWeights(Bootstrap(tree_id, dataset->Meta().size));
+                     return ForestBuildDriver::TreeSlot{trainer.tree.get(), &trainer.SampleWeights(), LeafHandler(),
+                                                        route_out_of_bag};
+                   },
+                   [this, &driver](uint32_t driver_tree_id) {
+                     uint32_t tree_id = first_tree_id + driver_tree_id;
+                     tree_trainers[tree_id]->ReadTree();
+                     if (FinishTree(tree_id))
+                       driver.StopStartingTrees();
+                   });
+  driver.Build();
+  num_trees = driver.NumTreesBuilt();
+  scheduling_stats.Merge(driver.Stats());
+  for (const auto &worker_stats: driver.Stats().worker_stats) {
+    driver_spin_time += worker_stats.spin_time;
+    driver_parked_time += worker_stats.parked_time;
+  }
+}
+
 void ForestTrainer::Predict() {
   if (cost_function == GiniImpurity || cost_function == Entropy) {
     PredictClassification();
@@ -64,14 +211,21 @@ void ForestTrainer::Predict() {
   }
 }
 
+const SchedulerStats &ForestTrainer::SchedulingStats() const {
+  return scheduling_stats;
+}
+
 void ForestTrainer::Report() {
   std::cout << "------------------------------" << std::endl;
   std::cout << "Training Time: " << training_time << " second(s)" << std::endl;
+  std::cout << "Idle Worker Time: " << spin_time << " second(s) spinning, "
+            << parked_time << " second(s) parked" << std::endl;
   std::cout << "------------------------------" << std::endl;
   std::cout << "Tree Description:" << std::endl;
   std::cout << "  Mean Depth: " << mean_depth << std::endl;
   std::cout << "  Mean Num Cells: " << mean_num_cell << std::endl;
   std::cout << "  Mean Num Leaves: " << mean_num_leaf << std::endl;
+  std::cout << "  Skipped Scans: " << num_skipped_scans << " / " << num_scans << std::endl;
   std::cout << "------------------------------" << std::endl;
   std::cout << "Loss as ";
   if (cost_function == GiniImpurity) {
@@ -100,6 +254,13 @@ void ForestTrainer::Report() {
     std::cout << "  Out of Bag Loss: " << oob_loss << std::endl;
   }
   std::cout << "------------------------------" << std::endl;
+  if (!oob_curve.empty()) {
+    std::cout << "Out of Bag Error by Num Trees: " << std::endl;
+    for (const auto &check: oob_curve)
+      std::cout << "  " << check.num_trees << ": " << check.oob_error << std::endl;
+    std::cout << "  Num Trees: " << tree_trainers.size() << std::endl;
+    std::cout << "------------------------------" << std::endl;
+  }
   std::cout << "Top 10 Feature Importance: " << std::endl;
   for (uint32_t idx = 0; idx != 10; ++idx) {
     if (idx == 5) std::cout << std::endl;
@@ -131,7 +292,19 @@ void ForestTrainer::Clear() {
   feature_rank.shrink_to_fit();
 }
 
+std::unique_ptr<TreeTrainer> ForestTrainer::MakeTreeTrainer(uint32_t tree_id) {
+  auto trainer = std::make_unique<TreeTrainer>(cost_function, params.num_features_for_split, params.min_leaf_node,
+                                               params.min_split_node, params.max_depth, params.max_num_nodes,
+                                               params.random_state + tree_id, num_threads);
+  trainer->SetNumaOptions(numa_options);
+  trainer->SetSchedulingPolicy(policy_id);
+  return trainer;
+}
+
+/// Kept from a warm start if it came with one
 void ForestTrainer::Presort() {
+  if (presorted_indices.size() == dataset->Meta().num_features)
+    return;
   presorted_indices.resize(dataset->Meta().num_features);
   for (uint32_t idx = 0; idx != dataset->Meta().num_features; ++idx)
     if (dataset->FeatureType(idx) == IsContinuous)
@@ -157,13 +330,183 @@ vec_uint32_t ForestTrainer::IndexSort(const std::vector<feature_t> &features) {
   return sorted_idx;
 }
 
-vec_uint32_t ForestTrainer::Bootstrap(uint32_t num_boot_samples) {
-  vec_uint32_t sample_weights(num_boot_samples, 0);
-  Random::SampleWithReplacement(num_boot_samples, num_boot_samples, sample_weights);
+/// Tree i draws under the seed of its builder, so its weights do not depend on which trees were drawn before it.
+/// Each chunk of samples has a stream of its own and is filled by one task. A multinomial bootstrap first splits
+/// the draws between the chunks, chunk c taking Binomial(draws left, size of c / samples left), which keeps it exact.
+vec_uint8_t ForestTrainer::Bootstrap(uint32_t tree_id,
+                                     uint32_t num_boot_samples) {
+  vec_uint8_t sample_weights(num_boot_samples, 0);
+  uint64_t key = params.random_state + tree_id;
+  uint32_t num_chunks = (num_boot_samples + NumSamplesPerBootstrapChunk - 1) / NumSamplesPerBootstrapChunk;
+  vec_uint32_t num_chunk_draws(num_chunks, 0);
+  if (bootstrap_mode == BootstrapMultinomial) {
+    Philox generator(key, Random::BootstrapStream);
+    uint32_t num_draws_left = num_boot_samples;
+    for (uint32_t chunk_idx = 0; chunk_idx != num_chunks; ++chunk_idx) {
+      uint32_t num_samples_left = num_boot_samples - chunk_idx * NumSamplesPerBootstrapChunk;
+      uint32_t chunk_size = std::min(num_samples_left, NumSamplesPerBootstrapChunk);
+      num_chunk_draws[chunk_idx] = Random::Binomial(num_draws_left, static_cast<double>(chunk_size) / num_samples_left,
+                                                    generator);
+      num_draws_left -= num_chunk_draws[chunk_idx];
+    }
+  }
+  std::atomic<uint32_t> next_chunk_idx(0);
+  ThreadPool::GetInstance().Run(std::min(num_threads, num_chunks), [&](uint32_t) {
+    for (uint32_t chunk_idx = next_chunk_idx++; chunk_idx < num_chunks; chunk_idx = next_chunk_idx++) {
+      uint32_t begin = chunk_idx * NumSamplesPerBootstrapChunk;
+      uint32_t chunk_size = std::min(num_boot_samples - begin, NumSamplesPerBootstrapChunk);
+      Philox generator(key, Random::Stream(Random::BootstrapStream, chunk_idx));
+      if (bootstrap_mode == BootstrapPoisson) {
+        Random::SamplePoisson(chunk_size, &sample_weights[begin], generator);
+      } else {
+        Random::SampleWithReplacement(chunk_size, num_chunk_draws[chunk_idx], &sample_weights[begin], generator);
+      }
+    }
+  });
   return sample_weights;
 }
 
+bool ForestTrainer::TrainTree(uint32_t tree_id,
+                              vec_uint8_t &&sample_weights) {
+  TreeTrainer &trainer = *tree_trainers[tree_id];
+  trainer.LoadData(dataset);
+  trainer.LoadSampleWeights(std::move(sample_weights));
+  trainer.SetLeafHandler(LeafHandler(), route_out_of_bag);
+  trainer.Train(false);
+  {
+    std::lock_guard<std::mutex> lock(accumulate_mut);
+    scheduling_stats.Merge(trainer.SchedulingStats());
+  }
+  return FinishTree(tree_id);
+}
+
+/// Predictions of a built tree go into the sums over trees, the tree itself is kept
+bool ForestTrainer::FinishTree(uint32_t tree_id) {
+  TreeTrainer &trainer = *tree_trainers[tree_id];
+  Accumulate(tree_id);
+  bool to_check = false;
+  uint32_t num_trees_checked = 0;
+  {
+    std::lock_guard<std::mutex> lock(accumulate_mut);
+    to_check = (num_trees_per_check != 0 && ++num_trees_done % num_trees_per_check == 0);
+    num_trees_checked = first_tree_id + num_trees_done;
+  }
+  bool to_stop = false;
+  if (to_check) {
+    // the error is read under the range locks only, checks that end out of turn still go in their place
+    double oob_error = OutOfBagError(tree_id);
+    std::lock_guard<std::mutex> lock(accumulate_mut);
+    auto pos = std::find_if(oob_curve.begin(), oob_curve.end(), [num_trees_checked](const OutOfBagCheck &check) {
+      return check.num_trees > num_trees_checked;
+    });
+    oob_curve.insert(pos, OutOfBagCheck{num_trees_checked, oob_error});
+    to_stop = HasConverged();
+  }
+  trainer.ClearBuilder();
+  trainer.ClearSampleWeights();
+  return to_stop;
+}
+
+/// Error of the out-of-bag sums as they stand, each range read under its lock. Other trees may have added to the sums
+/// since this one was counted, all of a tree that has finished too or, when the samples out of the bag are routed,
+/// the leaves made so far of a tree still in flight.
+double ForestTrainer::OutOfBagError(uint32_t tree_id) {
+  bool is_classification = (cost_function == GiniImpurity || cost_function == Entropy);
+  uint32_t num_classes = dataset->Meta().num_classes;
+  const auto &labels = dataset->Labels();
+  vec_dbl_t range_errors(num_output_ranges, 0.0);
+  vec_dbl_t range_counts(num_output_ranges, 0.0);
+  ForEachOutputRange(tree_id, [&](uint32_t begin, uint32_t end) {
+    double error = 0.0, count = 0.0;
+    for (uint32_t idx = begin; idx != end; ++idx) {
+      if (oob_count[idx] == 0) continue;
+      count += oob_count[idx];
+      if (is_classification) {
+        if (Maths::Argmax(&oob_output_prob[static_cast<size_t>(idx) * num_classes], num_classes) !=
+            Generics::RoundAt<uint32_t>(labels, idx))
+          error += oob_count[idx];
+      } else {
+        double diff = oob_output_mean[idx] / oob_count[idx] - Generics::RoundAt<double>(labels, idx);
+        error += oob_count[idx] * diff * diff;
+      }
+    }
+    range_errors[begin / NumSamplesPerOutputRange] = error;
+    range_counts[begin / NumSamplesPerOutputRange] = count;
+  });
+  double count = std::accumulate(range_counts.begin(), range_counts.end(), 0.0);
+  if (count == 0.0)
+    return std::numeric_limits<double>::infinity();
+  return std::accumulate(range_errors.begin(), range_errors.end(), 0.0) / count;
+}
+
+/// The error has dropped by less than the tolerance since the check window checks ago
+bool ForestTrainer::HasConverged() const {
+  if (oob_curve.size() <= stopping_window)
+    return false;
+  return oob_curve[oob_curve.size() - 1 - stopping_window].oob_error - oob_curve.back().oob_error < stopping_tolerance;
+}
+
+std::function<void(const TreeNode *)> ForestTrainer::LeafHandler() {
+  return [this](const TreeNode *leaf) {
+    AccumulateLeaf(leaf);
+  };
+}
+
+/// The samples in the bag that make a leaf are added straight from its subset, scaled by their weights, and so are the
+/// samples out of the bag routed to it. The value of the leaf comes from its stats, as in StoredTree.
+void ForestTrainer::AccumulateLeaf(const TreeNode *leaf) {
+  const Subdataset *subset = leaf->Subset();
+  bool is_classification = (cost_function == GiniImpurity || cost_function == Entropy);
+  uint32_t num_classes = dataset->Meta().num_classes;
+  vec_dbl_t probability;
+  double mean = 0.0;
+  if (is_classification)
+    probability = leaf->Stats()->Probability();
+  else
+    mean = leaf->Stats()->Mean();
+  const vec_uint32_t &sample_ids = subset->SampleIds();
+  const vec_uint32_t &sample_weights = subset->SampleWeights();
+  AddUnderRangeLocks(sample_ids, [&](size_t pos) {
+    uint32_t idx = sample_ids[pos];
+    uint32_t sample_weight = sample_weights[pos];
+    total_sample_weights[idx] += sample_weight;
+    if (is_classification) {
+      prob_t *row = &output_prob[static_cast<size_t>(idx) * num_classes];
+      for (uint32_t class_idx = 0; class_idx != num_classes; ++class_idx)
+        row[class_idx] += sample_weight * probability[class_idx];
+    } else {
+      output_mean[idx] += sample_weight * mean;
+    }
+  });
+  const vec_uint32_t &out_of_bag_ids = subset->OutOfBagIds();
+  AddUnderRangeLocks(out_of_bag_ids, [&](size_t pos) {
+    uint32_t idx = out_of_bag_ids[pos];
+    ++oob_count[idx];
+    if (is_classification) {
+      prob_t *row = &oob_output_prob[static_cast<size_t>(idx) * num_classes];
+      for (uint32_t class_idx = 0; class_idx != num_classes; ++class_idx)
+        row[class_idx] += probability[class_idx];
+    } else {
+      oob_output_mean[idx] += mean;
+    }
+  });
+}
+
+/// ids ascend, so they are added one range at a time, each under the lock of its range
+template <typename add_t>
+void ForestTrainer::AddUnderRangeLocks(const vec_uint32_t &ids,
+                                       const add_t &add) {
+  for (size_t begin = 0, end = 0; begin != ids.size(); begin = end) {
+    uint32_t range_idx = ids[begin] / NumSamplesPerOutputRange;
+    std::lock_guard<std::mutex> lock(output_range_muts[range_idx]);
+    for (; end != ids.size() && ids[end] / NumSamplesPerOutputRange == range_idx; ++end)
+      add(end);
+  }
+}
+
 void ForestTrainer::Accumulate(uint32_t tree_id) {
+  if (route_out_of_bag)
+    return;
   if (cost_function == GiniImpurity || cost_function == Entropy) {
     AccumulateClassification(tree_id);
   } else {
@@ -171,48 +514,77 @@ void ForestTrainer::Accumulate(uint32_t tree_id) {
   }
 }
 
+/// The tasks of a tree claim the ranges of samples one at a time, holding the lock of a range while they add to it.
+/// Trees start on different ranges, so trees that finish at the same time seldom wait for each other.
+void ForestTrainer::ForEachOutputRange(uint32_t tree_id,
+                                       const std::function<void(uint32_t, uint32_t)> &accumulate) {
+  std::atomic<uint32_t> num_claimed(0);
+  uint32_t first_range_idx = tree_id % num_output_ranges;
+  ThreadPool::GetInstance().Run(std::min(num_threads, num_output_ranges), [&](uint32_t) {
+    for (uint32_t claim = num_claimed++; claim < num_output_ranges; claim = num_claimed++) {
+      uint32_t range_idx = (first_range_idx + claim) % num_output_ranges;
+      uint32_t begin = range_idx * NumSamplesPerOutputRange;
+      uint32_t end = std::min(begin + NumSamplesPerOutputRange, dataset->Meta().size);
+      std::lock_guard<std::mutex> lock(output_range_muts[range_idx]);
+      accumulate(begin, end);
+    }
+  });
+}
+
+/// The samples in the bag are already in from the leaves they made, each sample out of the bag goes down the tree once
+/// and its leaf is added straight into the out-of-bag sums, no per-tree buffer is made. Nothing is left to add when the
+/// samples out of the bag were routed during the build.
 void ForestTrainer::AccumulateClassification(uint32_t tree_id) {
   TreeTrainer &trainer = *tree_trainers[tree_id];
-  const vec_uint32_t &sample_weights = dataset->SampleWeights();
-  for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
-    uint32_t sample_weight = sample_weights[idx];
-    if (sample_weight == 0) {
-      std::transform(oob_output_prob[idx].begin(), oob_output_prob[idx].end(), trainer.oob_output_prob[idx].begin(),
-                     oob_output_prob[idx].begin(), std::plus<>());
-    } else {
-      std::transform(output_prob[idx].begin(), output_prob[idx].end(),
-                     trainer.output_prob[idx].begin(), output_prob[idx].begin(),
-                     [&sample_weight](double &lhs, double &rhs) {
-                       return lhs + sample_weight * rhs;
-                     });
+  TreePredictor &predictor = *trainer.tree_predictor;
+  predictor.BindToTree(*dynamic_cast<const ClassificationStoredTree*>(trainer.tree.get()));
+  const vec_uint8_t &sample_weights = trainer.SampleWeights();
+  uint32_t num_classes = dataset->Meta().num_classes;
+  ForEachOutputRange(tree_id, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t idx = begin; idx != end; ++idx) {
+      if (sample_weights[idx] != 0) continue;
+      const vec_dbl_t &probability = predictor.PredictOneByProbability(dataset, idx);
+      prob_t *row = &oob_output_prob[static_cast<size_t>(idx) * num_classes];
+      for (uint32_t class_idx = 0; class_idx != num_classes; ++class_idx)
+        row[class_idx] += probability[class_idx];
+      ++oob_count[idx];
     }
-  }
-  std::transform(feature_importance.begin(), feature_importance.end(), trainer.feature_importance.begin(),
-                 feature_importance.begin(), std::plus<>());
-  trainer.ClearOutput();
+  });
 }
 
 void ForestTrainer::AccumulateRegression(uint32_t tree_id) {
   TreeTrainer &trainer = *tree_trainers[tree_id];
-  const vec_uint32_t &sample_weights = dataset->SampleWeights();
-  for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
-    uint32_t sample_weight = sample_weights[idx];
-    if (sample_weight == 0) {
-      oob_output_mean[idx] += trainer.oob_output_mean[idx];
-    } else {
-      output_mean[idx] += sample_weight * trainer.output_mean[idx];
+  TreePredictor &predictor = *trainer.tree_predictor;
+  predictor.BindToTree(*dynamic_cast<const RegressionStoredTree*>(trainer.tree.get()));
+  const vec_uint8_t &sample_weights = trainer.SampleWeights();
+  ForEachOutputRange(tree_id, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t idx = begin; idx != end; ++idx) {
+      if (sample_weights[idx] != 0) continue;
+      ++oob_count[idx];
+      oob_output_mean[idx] += predictor.PredictOneByMean(dataset, idx);
     }
-  }
-  std::transform(feature_importance.begin(), feature_importance.end(), trainer.feature_importance.begin(),
-                 feature_importance.begin(), std::plus<>());
-  trainer.ClearOutput();
+  });
 }
 
+/// Feature importance and the tree statistics are summed over all trees of the forest, kept ones included
 void ForestTrainer::Reduce() {
-  if (cost_function == GiniImpurity || cost_function == Entropy) {
-    ReduceClassification();
-  } else {
-    ReduceRegression();
+  feature_importance.assign(dataset->Meta().num_features, 0.0);
+  init_loss = final_loss = 0.0;
+  mean_depth = mean_num_cell = mean_num_leaf = 0.0;
+  num_scans = num_skipped_scans = 0;
+  spin_time = parked_time = 0.0;
+  for (const auto &trainer: tree_trainers) {
+    std::transform(feature_importance.begin(), feature_importance.end(), trainer->feature_importance.begin(),
+                   feature_importance.begin(), std::plus<>());
+    init_loss += trainer->init_loss;
+    final_loss += trainer->final_loss;
+    mean_depth += trainer->tree->max_depth;
+    mean_num_cell += trainer->tree->num_cell;
+    mean_num_leaf += trainer->tree->num_leaf;
+    num_scans += trainer->tree->num_scans;
+    num_skipped_scans += trainer->tree->num_skipped_scans;
+    spin_time += trainer->tree->spin_time;
+    parked_time += trainer->tree->parked_time;
   }
   Maths::Normalize(feature_importance);
   feature_rank.resize(dataset->Meta().num_features, 0);
@@ -222,45 +594,25 @@ void ForestTrainer::Reduce() {
             [&local_feature_importance](uint32_t x, uint32_t y) {
               return local_feature_importance[x] > local_feature_importance[y];
             });
-  for (uint32_t tree_id = 0; tree_id != num_trees; ++tree_id) {
-    init_loss += tree_trainers[tree_id]->init_loss;
-    final_loss += tree_trainers[tree_id]->final_loss;
-    mean_depth += tree_trainers[tree_id]->tree->max_depth;
-    mean_num_cell += tree_trainers[tree_id]->tree->num_cell;
-    mean_num_leaf += tree_trainers[tree_id]->tree->num_leaf;
-  }
-  init_loss /= num_trees;
-  final_loss /= num_trees;
+  double num_forest_trees = tree_trainers.size();
+  init_loss /= num_forest_trees;
+  final_loss /= num_forest_trees;
   relative_loss_reduction = 1 - final_loss / init_loss;
-  mean_depth /= num_trees;
-  mean_num_cell /= num_trees;
-  mean_num_leaf /= num_trees;
-}
-
-void ForestTrainer::ReduceClassification() {
-  for (auto &histogram: output_prob)
-    Maths::Normalize(histogram);
-  for (auto &histogram: oob_output_prob)
-    Maths::Normalize(histogram);
-}
-
-void ForestTrainer::ReduceRegression() {
-  for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
-    if (total_sample_weights[idx] > 0)
-      output_mean[idx] /= total_sample_weights[idx];
-    if (oob_count[idx] > 0)
-      oob_output_mean[idx] /= oob_count[idx];
-  }
+  mean_depth /= num_forest_trees;
+  mean_num_cell /= num_forest_trees;
+  mean_num_leaf /= num_forest_trees;
 }
 
 void ForestTrainer::PredictClassification() {
   uint32_t correct_count = 0;
   uint32_t total_count = 0;
+  uint32_t num_classes = dataset->Meta().num_classes;
   const auto &labels = dataset->Labels();
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
     if (total_sample_weights[idx] == 0) continue;
     total_count += total_sample_weights[idx];
-    if (Maths::Argmax(output_prob[idx]) == Generics::RoundAt<uint32_t>(labels, idx))
+    if (Maths::Argmax(&output_prob[static_cast<size_t>(idx) * num_classes], num_classes) ==
+        Generics::RoundAt<uint32_t>(labels, idx))
       correct_count += total_sample_weights[idx];
   }
   train_accuracy = static_cast<double>(correct_count) / static_cast<double>(total_count);
@@ -270,7 +622,8 @@ void ForestTrainer::PredictClassification() {
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
     if (oob_count[idx] == 0) continue;
     total_count += oob_count[idx];
-    if (Maths::Argmax(oob_output_prob[idx]) == Generics::RoundAt<uint32_t>(labels, idx))
+    if (Maths::Argmax(&oob_output_prob[static_cast<size_t>(idx) * num_classes], num_classes) ==
+        Generics::RoundAt<uint32_t>(labels, idx))
       correct_count += oob_count[idx];
   }
   oob_accuracy = static_cast<double>(correct_count) / static_cast<double>(total_count);
@@ -278,15 +631,17 @@ void ForestTrainer::PredictClassification() {
 
 void ForestTrainer::PredictRegression() {
   const auto &labels = dataset->Labels();
+  train_loss = 0.0;
+  oob_loss = 0.0;
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
     if (total_sample_weights[idx] == 0) continue;
-    double diff = output_mean[idx] - Generics::RoundAt<double>(labels, idx);
+    double diff = output_mean[idx] / total_sample_weights[idx] - Generics::RoundAt<double>(labels, idx);
     train_loss += total_sample_weights[idx] * diff * diff;
   }
   train_loss /= std::accumulate(total_sample_weights.begin(), total_sample_weights.end(), 0u);
   for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
     if (oob_count[idx] == 0) continue;
-    double diff = oob_output_mean[idx] - Generics::RoundAt<double>(labels, idx);
+    double diff = oob_output_mean[idx] / oob_count[idx] - Generics::RoundAt<double>(labels, idx);
     oob_loss += oob_count[idx] * diff * diff;
   }
   oob_loss /= std::accumulate(oob_count.begin(), oob_count.end(), 0u);
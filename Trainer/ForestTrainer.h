@@ -2,13 +2,37 @@
 #ifndef DECISIONTREE_FORESTBUILDER_H
 #define DECISIONTREE_FORESTBUILDER_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "../TreeBuilder/TreeBuilder.h"
+#include "../Tree/TreeParams.h"
 #include "../Dataset/Dataset.h"
 #include "../Dataset/IndexedFeature.h"
 #include "TreeTrainer.h"
 
 class ForestTrainer {
  public:
+  /// Out-of-bag error of the forest once num_trees trees were done, see SetEarlyStopping
+  struct OutOfBagCheck {
+    uint32_t num_trees;
+    double oob_error;
+  };
+
+  /// What a trained forest carries over to warm start another one on the same dataset, see ReleaseState: its trees,
+  /// the per-sample sums over them, and the presort
+  struct ForestState {
+    std::vector<std::unique_ptr<StoredTree>> trees;
+    vec_uint32_t total_sample_weights;
+    vec_uint32_t oob_count;
+    vec_prob_t output_prob;
+    vec_dbl_t output_mean;
+    vec_prob_t oob_output_prob;
+    vec_dbl_t oob_output_mean;
+    vec_vec_uint32_t presorted_indices;
+  };
+
   ForestTrainer(uint32_t cost_function,
                 uint32_t num_features_for_split,
                 uint32_t min_leaf_node,
@@ -19,25 +43,74 @@ class ForestTrainer {
                 uint32_t num_threads,
                 uint32_t num_trees):
     num_trees(num_trees), cost_function(cost_function),
+    params(cost_function, min_leaf_node, min_split_node, max_depth, max_num_nodes, num_features_for_split,
+           random_state),
+    num_threads(num_threads), num_concurrent_trees(1), numa_options(NumaDefault), policy_id(LocalFirst),
+    bootstrap_mode(BootstrapMultinomial), route_out_of_bag(false), num_trees_per_check(0), stopping_window(0),
+    stopping_tolerance(0.0), num_trees_done(0), oob_curve(), first_tree_id(0),
     dataset(nullptr), presorted_indices(), total_sample_weights(), oob_count(), output_prob(), output_mean(),
     oob_output_prob(), oob_output_mean(), feature_importance(), feature_rank(), train_accuracy(0.0),
     train_loss(0.0), init_loss(0.0), final_loss(0.0), relative_loss_reduction(0.0), training_time(0.0),
-    mean_depth(0.0), mean_num_cell(0.0), mean_num_leaf(0.0) {
+    mean_depth(0.0), mean_num_cell(0.0), mean_num_leaf(0.0),
+    num_scans(0), num_skipped_scans(0), spin_time(0.0), parked_time(0.0), scheduling_stats(), accumulate_mut(),
+    num_output_ranges(0), output_range_muts() {
     tree_trainers.reserve(num_trees);
     for (uint32_t tree_id = 0; tree_id != num_trees; ++tree_id)
-      tree_trainers.emplace_back(std::make_unique<TreeTrainer>(cost_function, num_features_for_split, min_leaf_node,
-                                                               min_split_node, max_depth, max_num_nodes,
-                                                               random_state + tree_id, num_threads));
+      tree_trainers.emplace_back(MakeTreeTrainer(tree_id));
   };
   void LoadData(Dataset *dataset);
+  void SetNumaOptions(uint32_t numa_options);
+  void SetSchedulingPolicy(uint32_t policy_id);
+  /// Number of trees built at the same time, each with the num_threads workers of its own build.
+  /// 1, the default, builds one tree after another. AdaptiveTreeParallelism builds all trees on one set of
+  /// num_threads workers, which move from tree to tree as the job queue and their idle time tell,
+  /// see ForestBuildDriver.
+  void SetTreeParallelism(uint32_t num_concurrent_trees);
+  /// BootstrapMultinomial, the default, or BootstrapPoisson
+  void SetBootstrapMode(uint32_t bootstrap_mode);
+  /// Send the out-of-bag samples of each tree down with its in-bag samples while it is built, they take the value
+  /// of the leaf they reach when it is made, instead of going through the finished tree
+  void SetOutOfBagRouting(bool route_out_of_bag);
+  /// Every num_trees_per_check trees the out-of-bag error, one minus the accuracy or the loss, is taken over the trees
+  /// done so far, and no more trees are started once it has dropped by less than tolerance over the last window
+  /// checks. The trees already started are finished and kept. num_trees_per_check 0, the default, builds all trees.
+  /// With more than one tree in flight the error can take in trees that are not counted yet, so the curve and the
+  /// number of trees it stops at vary from run to run. Trees built one after another give the same curve every time.
+  void SetEarlyStopping(uint32_t num_trees_per_check,
+                        uint32_t window,
+                        double tolerance);
+  /// Checks of the last training, empty without early stopping
+  const std::vector<OutOfBagCheck> &OutOfBagCurve() const;
+  /// Keep the trees of an earlier forest and the sums over them, then Train builds num_trees more, seeded after the
+  /// kept ones, and adds them in. Call after LoadData, with the dataset the state was trained on.
+  void WarmStart(ForestState &&state);
+  /// Hand the trees, the sums and the presort over after training, this trainer is left without trees
+  ForestState ReleaseState();
   void Train(bool to_report);
   void Predict();
   void Report();
+  /// Scheduler counters summed over the builds of all trees
+  const SchedulerStats &SchedulingStats() const;
   void Clear();
 
  private:
   uint32_t num_trees;
   const uint32_t cost_function;
+  const TreeParams params;
+  const uint32_t num_threads;
+  uint32_t num_concurrent_trees;
+  uint32_t numa_options;
+  uint32_t policy_id;
+  uint32_t bootstrap_mode;
+  bool route_out_of_bag;
+  uint32_t num_trees_per_check;
+  uint32_t stopping_window;
+  double stopping_tolerance;
+  /// Trees done in the current training, counted under accumulate_mut
+  uint32_t num_trees_done;
+  std::vector<OutOfBagCheck> oob_curve;
+  /// Trees kept from a warm start, the trees Train builds are numbered after them
+  uint32_t first_tree_id;
 
   std::vector<std::unique_ptr<TreeTrainer>> tree_trainers;
   Dataset *dataset;
@@ -45,10 +118,12 @@ class ForestTrainer {
   vec_uint32_t total_sample_weights;
   vec_uint32_t oob_count;
 
-  vec_vec_dbl_t output_prob;
+  /// Sums over trees, flat N x C, see prob_t. They stay sums, so that more trees can be added to them,
+  /// and are divided by total_sample_weights or oob_count where they are read.
+  vec_prob_t output_prob;
   vec_dbl_t output_mean;
 
-  vec_vec_dbl_t oob_output_prob;
+  vec_prob_t oob_output_prob;
   vec_dbl_t oob_output_mean;
 
   vec_dbl_t feature_importance;
@@ -65,19 +140,46 @@ class ForestTrainer {
   double mean_depth;
   double mean_num_cell;
   double mean_num_leaf;
+  uint64_t num_scans;
+  uint64_t num_skipped_scans;
+  double spin_time;
+  double parked_time;
+  SchedulerStats scheduling_stats;
+  /// Guards the sums over trees that are not per sample, which concurrent trees add to as they finish
+  std::mutex accumulate_mut;
+  /// One lock for each range of NumSamplesPerOutputRange samples of the per-sample sums
+  uint32_t num_output_ranges;
+  std::unique_ptr<std::mutex[]> output_range_muts;
 
+  std::unique_ptr<TreeTrainer> MakeTreeTrainer(uint32_t tree_id);
   void Presort();
 
   template <typename feature_t>
   vec_uint32_t IndexSort(const std::vector<feature_t> &features);
 
-  vec_uint32_t Bootstrap(uint32_t num_boot_samples);
+  vec_uint8_t Bootstrap(uint32_t tree_id,
+                        uint32_t num_boot_samples);
+  void TrainInTurns();
+  /// The idle time of the shared workers is summed into driver_spin_time and driver_parked_time
+  void TrainAdaptively(double &driver_spin_time,
+                       double &driver_parked_time);
+  bool TrainTree(uint32_t tree_id,
+                 vec_uint8_t &&sample_weights);
+  /// Whether the forest should stop growing, see SetEarlyStopping
+  bool FinishTree(uint32_t tree_id);
+  double OutOfBagError(uint32_t tree_id);
+  bool HasConverged() const;
+  std::function<void(const TreeNode *)> LeafHandler();
+  void AccumulateLeaf(const TreeNode *leaf);
+  template <typename add_t>
+  void AddUnderRangeLocks(const vec_uint32_t &ids,
+                          const add_t &add);
   void Accumulate(uint32_t tree_id);
+  void ForEachOutputRange(uint32_t tree_id,
+                          const std::function<void(uint32_t, uint32_t)> &accumulate);
   void AccumulateClassification(uint32_t tree_id);
   void AccumulateRegression(uint32_t tree_id);
   void Reduce();
-  void ReduceClassification();
-  void ReduceRegression();
   void PredictClassification();
   void PredictRegression();
 };
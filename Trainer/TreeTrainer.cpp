@@ -1,6 +1,7 @@
 
 #include "TreeTrainer.h"
 #include "../Predictor/ParallelTreePredictor.h"
+#include "../Parallel/ThreadPool.h"
 
 TreeTrainer::TreeTrainer(uint32_t cost_function,
                          uint32_t num_features_for_split,
@@ -10,10 +11,11 @@ TreeTrainer::TreeTrainer(uint32_t cost_function,
                          uint32_t max_num_nodes,
                          uint32_t random_state,
                          uint32_t num_threads):
-  dataset(nullptr), cost_function(cost_function), train_accuracy(0.0), train_loss(0.0),
-  init_loss(0.0), final_loss(0.0), relative_loss_reduction(0.0), feature_importance(), training_time(0.0),
   driver(std::make_unique<SingleTreeBuildDriver>(cost_function, min_leaf_node, min_split_node, num_features_for_split,
-                                                 random_state, num_threads, max_num_nodes, max_depth)) {
+                                                 random_state, num_threads, max_num_nodes, max_depth)),
+  dataset(nullptr), sample_weights(), cost_function(cost_function), feature_importance(), train_accuracy(0.0),
+  train_loss(0.0), init_loss(0.0), final_loss(0.0), relative_loss_reduction(0.0), training_time(0.0),
+  numa_options(NumaDefault), scheduling_stats() {
   if (num_threads == 1) {
     tree_predictor = std::make_unique<TreePredictor>();
   } else {
@@ -29,21 +31,77 @@ void TreeTrainer::LoadData(Dataset *dataset) {
   this->dataset = dataset;
 }
 
-void TreeTrainer::LoadSampleWeights(vec_uint32_t &&sample_weights) {
-  dataset->AddSampleWeights(std::move(sample_weights));
+void TreeTrainer::LoadSampleWeights(vec_uint8_t &&sample_weights) {
+  this->sample_weights = std::move(sample_weights);
 }
 
 void TreeTrainer::LoadDefaultSampleWeights() {
-  vec_uint32_t default_sample_weights(dataset->Meta().size, 1);
-  dataset->AddSampleWeights(std::move(default_sample_weights));
+  sample_weights.assign(dataset->Meta().size, 1);
+}
+
+const vec_uint8_t &TreeTrainer::SampleWeights() const {
+  return sample_weights;
+}
+
+uint32_t TreeTrainer::SampleWeight(uint32_t idx) const {
+  return sample_weights.empty()? dataset->SampleWeights()[idx] : sample_weights[idx];
+}
+
+const vec_uint8_t *TreeTrainer::LoadedSampleWeights() const {
+  return sample_weights.empty()? nullptr : &sample_weights;
+}
+
+void TreeTrainer::SetLeafHandler(const std::function<void(const TreeNode *)> &leaf_handler,
+                                 bool route_out_of_bag) {
+  driver->SetLeafHandler(leaf_handler, route_out_of_bag);
+}
+
+void TreeTrainer::SetNumaOptions(uint32_t numa_options) {
+  this->numa_options = numa_options;
+}
+
+void TreeTrainer::SetSchedulingPolicy(uint32_t policy_id) {
+  driver->SetSchedulingPolicy(policy_id);
+}
+
+void TreeTrainer::SetTracing(bool tracing) {
+  driver->SetTracing(tracing);
+}
+
+const SchedulerStats &TreeTrainer::SchedulingStats() const {
+  return scheduling_stats;
+}
+
+void TreeTrainer::WriteTrace(std::ostream &out) const {
+  driver->WriteTrace(out);
 }
 
 void TreeTrainer::Train(bool to_report = true) {
   auto begin = std::chrono::high_resolution_clock::now();
+  if (numa_options & NumaPinWorkers)
+    ThreadPool::GetInstance().Reserve(0, true);
+  dataset->PlaceFeatures(numa_options);
   driver->LoadDataset(dataset);
+  driver->LoadSampleWeights(LoadedSampleWeights());
+  if (!to_report)
+    leaf_ids.clear();
+  driver->LoadLeafIds(to_report? &leaf_ids : nullptr);
   driver->LoadTree(tree.get());
   driver->Build();
+  scheduling_stats = driver->Stats();
+  ReadTree();
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> time_duration = end - begin;
+  training_time = time_duration.count();
+
+  if (to_report) {
+    Predict(true, false);
+    Report();
+  }
+}
 
+/// Losses and feature importance of the built tree
+void TreeTrainer::ReadTree() {
   init_loss = tree->init_loss;
   final_loss = tree->final_loss;
   relative_loss_reduction = tree->relative_loss_reduction;
@@ -56,14 +114,6 @@ void TreeTrainer::Train(bool to_report = true) {
             [&local_feature_importance](uint32_t x, uint32_t y) {
               return local_feature_importance[x] > local_feature_importance[y];
             });
-  auto end = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> time_duration = end - begin;
-  training_time = time_duration.count();
-
-  if (to_report) {
-    Predict(true, false);
-    Report();
-  }
 }
 
 void TreeTrainer::Predict(bool get_output,
@@ -78,11 +128,14 @@ void TreeTrainer::Predict(bool get_output,
 void TreeTrainer::Report() {
   std::cout << "------------------------------" << std::endl;
   std::cout << "Training Time: " << training_time << " second(s)" << std::endl;
+  std::cout << "Idle Worker Time: " << tree->spin_time << " second(s) spinning, "
+            << tree->parked_time << " second(s) parked" << std::endl;
   std::cout << "------------------------------" << std::endl;
   std::cout << "Tree Description:" << std::endl;
   std::cout << "  Depth: " << tree->max_depth << std::endl;
   std::cout << "  Num Cells: " << tree->num_cell << std::endl;
   std::cout << "  Num Leaves: " << tree->num_leaf << std::endl;
+  std::cout << "  Skipped Scans: " << tree->num_skipped_scans << " / " << tree->num_scans << std::endl;
   std::cout << "------------------------------" << std::endl;
   std::cout << "Loss as ";
   if (cost_function == GiniImpurity) {
@@ -112,6 +165,10 @@ void TreeTrainer::Report() {
   std::cout << std::endl << "------------------------------" << std::endl;
 }
 
+const vec_int32_t &TreeTrainer::LeafIds() const {
+  return leaf_ids;
+}
+
 void TreeTrainer::ClearOutput() {
   output_prob.clear();
   output_prob.shrink_to_fit();
@@ -121,6 +178,8 @@ void TreeTrainer::ClearOutput() {
   oob_output_prob.shrink_to_fit();
   oob_output_mean.clear();
   oob_output_mean.shrink_to_fit();
+  leaf_ids.clear();
+  leaf_ids.shrink_to_fit();
 }
 
 void TreeTrainer::ClearBuilder() {
@@ -128,27 +187,48 @@ void TreeTrainer::ClearBuilder() {
   tree_predictor.reset();
 }
 
+void TreeTrainer::ClearSampleWeights() {
+  sample_weights.clear();
+  sample_weights.shrink_to_fit();
+}
+
 void TreeTrainer::ClearTree() {
   tree.reset();
 }
 
+/// Samples in the bag take the leaf they were recorded at, if the build recorded them, so only the samples out of
+/// the bag go down the tree
 void TreeTrainer::PredictClassification(bool get_output,
                                         bool get_oob_pred) {
   const auto *class_tree = dynamic_cast<const ClassificationStoredTree*>(tree.get());
   tree_predictor->BindToTree(*class_tree);
-  output_prob = tree_predictor->PredictBatchByProbability(dataset, PredictPresent);
-  if (get_oob_pred)
-    oob_output_prob = tree_predictor->PredictBatchByProbability(dataset, PredictAbsent);
+  tree_predictor->LoadSampleWeights(LoadedSampleWeights());
+  uint32_t num_classes = dataset->Meta().num_classes;
+  output_prob.assign(static_cast<size_t>(dataset->Meta().size) * num_classes, 0.0);
+  if (leaf_ids.empty()) {
+    tree_predictor->PredictBatchByProbability(dataset, output_prob.data(), PredictPresent);
+  } else {
+    for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx)
+      if (leaf_ids[idx] >= 0)
+        std::copy(class_tree->leaf_probability[leaf_ids[idx]].begin(),
+                  class_tree->leaf_probability[leaf_ids[idx]].end(),
+                  &output_prob[static_cast<size_t>(idx) * num_classes]);
+  }
+  if (get_oob_pred) {
+    oob_output_prob.assign(output_prob.size(), 0.0);
+    tree_predictor->PredictBatchByProbability(dataset, oob_output_prob.data(), PredictAbsent);
+  }
   if (get_output) {
     uint32_t correct_count = 0;
     uint32_t total_count = 0;
     const auto &labels = dataset->Labels();
-    const auto &sample_weights = dataset->SampleWeights();
     for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
-      if (sample_weights[idx] == 0) continue;
-      total_count += sample_weights[idx];
-      if (Maths::Argmax(output_prob[idx]) == Generics::RoundAt<uint32_t>(labels, idx))
-        correct_count += sample_weights[idx];
+      uint32_t sample_weight = SampleWeight(idx);
+      if (sample_weight == 0) continue;
+      total_count += sample_weight;
+      if (Maths::Argmax(&output_prob[static_cast<size_t>(idx) * num_classes], num_classes) ==
+          Generics::RoundAt<uint32_t>(labels, idx))
+        correct_count += sample_weight;
     }
     train_accuracy = static_cast<double>(correct_count) / static_cast<double>(total_count);
   }
@@ -158,16 +238,26 @@ void TreeTrainer::PredictRegression(bool get_output,
                                     bool get_oob_pred) {
   const auto *regress_tree = dynamic_cast<const RegressionStoredTree*>(tree.get());
   tree_predictor->BindToTree(*regress_tree);
-  output_mean = tree_predictor->PredictBatchByMean(dataset, PredictPresent);
+  tree_predictor->LoadSampleWeights(LoadedSampleWeights());
+  if (leaf_ids.empty()) {
+    output_mean = tree_predictor->PredictBatchByMean(dataset, PredictPresent);
+  } else {
+    output_mean.assign(dataset->Meta().size, 0.0);
+    for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx)
+      if (leaf_ids[idx] >= 0)
+        output_mean[idx] = regress_tree->leaf_mean[leaf_ids[idx]];
+  }
   if (get_oob_pred)
     oob_output_mean = tree_predictor->PredictBatchByMean(dataset, PredictAbsent);
   if (get_output) {
     const auto &labels = dataset->Labels();
-    const auto &sample_weights = dataset->SampleWeights();
+    uint32_t total_count = 0;
     for (uint32_t idx = 0; idx != dataset->Meta().size; ++idx) {
+      uint32_t sample_weight = SampleWeight(idx);
       double diff = output_mean[idx] - Generics::RoundAt<double>(labels, idx);
-      train_loss += sample_weights[idx] * diff * diff;
+      train_loss += sample_weight * diff * diff;
+      total_count += sample_weight;
     }
-    train_loss /= Generics::Round<double>(dataset->Meta().num_samples);
+    train_loss /= total_count;
   }
 }
\ No newline at end of file
@@ -20,12 +20,31 @@ class TreeTrainer {
               uint32_t random_state,
               uint32_t num_threads);
   void LoadData(Dataset *dataset);
-  void LoadSampleWeights(vec_uint32_t &&sample_weights);
+  /// The weights belong to this tree, the dataset keeps its own, so trees can share a dataset while they train
+  void LoadSampleWeights(vec_uint8_t &&sample_weights);
   void LoadDefaultSampleWeights();
+  /// Weights of this tree, empty if it trains on the weights of the dataset
+  const vec_uint8_t &SampleWeights() const;
+  /// See TreeBuilder::SetLeafHandler
+  void SetLeafHandler(const std::function<void(const TreeNode *)> &leaf_handler,
+                      bool route_out_of_bag);
+  /// NumaPinWorkers, NumaInterleaveFeatures and NumaReplicateFeatures, applied when training starts
+  void SetNumaOptions(uint32_t numa_options);
+  /// LocalFirst, LargestSubsetFirst or EstimatedWorkFirst
+  void SetSchedulingPolicy(uint32_t policy_id);
+  void SetTracing(bool tracing);
   void Train(bool to_report);
   void Report();
+  /// Scheduler counters of the build, SchedulerStats::WriteJson dumps them
+  const SchedulerStats &SchedulingStats() const;
+  /// Job timeline of the last build, for chrome://tracing or Perfetto, see SetTracing
+  void WriteTrace(std::ostream &out) const;
+  /// Leaf of each sample in the bag and -1 for the others, recorded by a build that reports, see
+  /// TreeBuilder::LoadLeafIds
+  const vec_int32_t &LeafIds() const;
   void ClearOutput();
   void ClearBuilder();
+  void ClearSampleWeights();
   void ClearTree();
 
  private:
@@ -33,6 +52,7 @@ class TreeTrainer {
   std::unique_ptr<TreePredictor> tree_predictor;
   std::unique_ptr<StoredTree> tree;
   Dataset *dataset;
+  vec_uint8_t sample_weights;
 
   const uint32_t cost_function;
 
@@ -44,14 +64,23 @@ class TreeTrainer {
   double final_loss;
   double relative_loss_reduction;
 
-  vec_vec_dbl_t output_prob;
+  /// Flat N x C, see prob_t
+  vec_prob_t output_prob;
   vec_dbl_t output_mean;
 
-  vec_vec_dbl_t oob_output_prob;
+  vec_prob_t oob_output_prob;
   vec_dbl_t oob_output_mean;
 
+  vec_int32_t leaf_ids;
+
   double training_time;
+  uint32_t numa_options;
+  SchedulerStats scheduling_stats;
 
+  void ReadTree();
+  /// Weight of one sample, of this tree or of the dataset
+  uint32_t SampleWeight(uint32_t idx) const;
+  const vec_uint8_t *LoadedSampleWeights() const;
   void Predict(bool get_output,
                bool get_oob_pred);
   void PredictClassification(bool get_output,
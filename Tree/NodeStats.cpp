@@ -7,13 +7,24 @@
 #include "../Util/Maths.h"
 #include "../Util/Cost.h"
 
+vec_dbl_t NodeStats::Probability() const {
+  vec_dbl_t probability = histogram;
+  Maths::Normalize(probability);
+  return probability;
+}
+
+double NodeStats::Mean() const {
+  return sum / num_samples;
+}
+
 void NodeStats::SetClassificationStats(const Subdataset *subset,
-                                       const Dataset *dataset) {
+                                       const Dataset *dataset,
+                                       const uint32_t cost_function) {
   histogram = boost::apply_visitor([&dataset, &subset] (const auto &labels) {
     return Maths::BuildHistogram(labels, subset->SampleWeights(), dataset->ClassWeights());
   }, subset->Labels());
   wnum_samples = accumulate(histogram.cbegin(), histogram.cend(), 0.0);
-  cost = Cost::Cost(histogram);
+  cost = Cost::Cost(cost_function, histogram);
 }
 
 void NodeStats::SetRegressionStats(const Subdataset *subset,
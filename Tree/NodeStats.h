@@ -39,11 +39,15 @@ class NodeStats {
     return square_sum;
   }
 
+  /// Value of a leaf with these stats: the normalized histogram for classification, the mean for regression
+  vec_dbl_t Probability() const;
+  double Mean() const;
+
   void SetStats(const Subdataset *subset,
                 const Dataset *dataset,
                 const uint32_t cost_function) {
     if (cost_function == GiniImpurity || cost_function == Entropy)
-      SetClassificationStats(subset, dataset);
+      SetClassificationStats(subset, dataset, cost_function);
     if (cost_function == Variance)
       SetRegressionStats(subset, dataset);
   }
@@ -62,7 +66,8 @@ class NodeStats {
   double square_sum;
 
   void SetClassificationStats(const Subdataset *subset,
-                              const Dataset *dataset);
+                              const Dataset *dataset,
+                              const uint32_t cost_function);
   void SetRegressionStats(const Subdataset *subset,
                           const Dataset *dataset);
 };
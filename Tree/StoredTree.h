@@ -21,6 +21,14 @@ class StoredTree {
   uint32_t max_depth;
   uint32_t num_bitmask;
 
+  /// Number of feature scans during the build, and how many of them were skipped by gain bound pruning
+  uint32_t num_scans;
+  uint32_t num_skipped_scans;
+
+  /// Seconds the workers spent without a job during the build, spinning and parked
+  double spin_time;
+  double parked_time;
+
   vec_uint32_t cell_type;
   std::vector<Info> cell_info;
   vec_int32_t left;
@@ -36,8 +44,9 @@ class StoredTree {
   double relative_loss_reduction;
 
   StoredTree():
-          num_cell(0), num_leaf(0), num_bitmask(0), max_depth(0), cell_type(), cell_info(), left(), right(),
-          bitmasks(), feature_importance(), total_gain(0.0), final_loss(0.0), relative_loss_reduction(0.0) {};
+          num_cell(0), num_leaf(0), num_bitmask(0), max_depth(0), num_scans(0), num_skipped_scans(0), spin_time(0.0),
+          parked_time(0.0), cell_type(), cell_info(), left(), right(), bitmasks(), feature_importance(),
+          total_gain(0.0), final_loss(0.0), relative_loss_reduction(0.0) {};
 
   virtual ~StoredTree() = default;
 
@@ -86,7 +95,7 @@ class StoredTree {
         break;
       case IsHighCardinality:
         cell_info[cell_id].integer = num_bitmask;
-        bitmasks[num_bitmask++] = *node->Split()->info.ptr_type;
+        bitmasks[num_bitmask++] = node->Split()->bitmask;
         break;
       default:
         break;
@@ -124,8 +133,7 @@ class ClassificationStoredTree: public StoredTree {
                    const int32_t parent_id) override {
     StoredTree::WriteToLeaf(node, leaf_id, parent_id);
     Maths::CastAndCopyVisitor<float> visitor;
-    leaf_probability[leaf_id] = node->Stats()->Histogram();
-    Maths::Normalize(leaf_probability[leaf_id]);
+    leaf_probability[leaf_id] = node->Stats()->Probability();
   }
 };
 
@@ -147,7 +155,7 @@ class RegressionStoredTree: public StoredTree {
                    const int32_t leaf_id,
                    const int32_t parent_id) override {
     StoredTree::WriteToLeaf(node, leaf_id, parent_id);
-    leaf_mean[leaf_id] = node->Stats()->Sum() / node->Stats()->NumSamples();
+    leaf_mean[leaf_id] = node->Stats()->Mean();
   }
 };
 
@@ -5,19 +5,27 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <atomic>
 #include <cassert>
 
 #include "../Splitter/SplitInfo.h"
+#include "../Splitter/BinRangeSplit.h"
 #include "TreeParams.h"
 #include "NodeStats.h"
 #include "../Dataset/Dataset.h"
 #include "../Dataset/Subdataset.h"
+#include "../Util/Random.h"
 
 class TreeNode {
  public:
-  explicit TreeNode(const Dataset *dataset):
-    type(IsRootType), depth(1), parent(nullptr), left(nullptr), right(nullptr), left_child_processed(false),
-    right_child_processed(false), subset(std::make_unique<Subdataset>(dataset)), split_info(nullptr), stats(nullptr) {}
+  template <typename weight_t>
+  TreeNode(const Dataset *dataset,
+           const std::vector<weight_t> &sample_weights,
+           bool route_out_of_bag = false):
+    type(IsRootType), depth(1), key(0), leaf_idx(0),
+    parent(nullptr), left(nullptr), right(nullptr), num_pending_children(0),
+    subset(std::make_unique<Subdataset>(dataset, sample_weights, route_out_of_bag)), split_info(nullptr), candidates(),
+    range_splits(), num_pending_candidates(0), best_candidate_gain(0.0), stats(nullptr) {}
 
   void SetStats(const Dataset *dataset,
                 const uint32_t cost_function) {
@@ -29,6 +37,52 @@ class TreeNode {
     split_info = std::make_unique<SplitInfo>();
   }
 
+  /// Prepare one candidate slot for each feature to be searched in parallel
+  void InitSplitInfo(uint32_t num_candidates) {
+    split_info = std::make_unique<SplitInfo>();
+    candidates.resize(num_candidates);
+    range_splits.resize(num_candidates);
+    num_pending_candidates = num_candidates;
+    best_candidate_gain = 0.0;
+  }
+
+  SplitInfo *Candidate(uint32_t candidate_idx) {
+    return &candidates[candidate_idx];
+  }
+
+  /// Best gain among the candidates finished so far, a lower bound of the gain of the split of this node
+  double BestCandidateGain() const {
+    return best_candidate_gain.load(std::memory_order_relaxed);
+  }
+
+  void PublishCandidateGain(double gain) {
+    double best = best_candidate_gain.load(std::memory_order_relaxed);
+    while (gain > best && !best_candidate_gain.compare_exchange_weak(best, gain, std::memory_order_relaxed)) {}
+  }
+
+  /// Brute force search of a candidate cut into bin ranges, null if the candidate was searched in one go
+  std::unique_ptr<BinRangeSplit> &RangeSplit(uint32_t candidate_idx) {
+    return range_splits[candidate_idx];
+  }
+
+  void DiscardRangeSplit(uint32_t candidate_idx) {
+    range_splits[candidate_idx].reset();
+  }
+
+  /// Count down the candidates still being searched.
+  /// The caller that finishes the last one reduces all candidates into the split info of this node and returns true.
+  bool FinishCandidate() {
+    if (--num_pending_candidates != 0)
+      return false;
+    split_info->Reduce(candidates);
+    split_info->FinishUpdate();
+    candidates.clear();
+    candidates.shrink_to_fit();
+    range_splits.clear();
+    range_splits.shrink_to_fit();
+    return true;
+  }
+
   void DiscardTemporaryElements() {
     subset->DiscardTemporaryElements();
   }
@@ -61,6 +115,20 @@ class TreeNode {
     return depth;
   }
 
+  /// Names the node by its path from the root, the random draws for the node come from streams under this key
+  uint64_t Key() const {
+    return key;
+  }
+
+  /// Rank of a leaf among the leaves of its tree in the order they were made
+  uint32_t LeafIdx() const {
+    return leaf_idx;
+  }
+
+  void SetLeafIdx(uint32_t leaf_idx) {
+    this->leaf_idx = leaf_idx;
+  }
+
   TreeNode *Parent() const {
     return parent;
   }
@@ -73,27 +141,22 @@ class TreeNode {
     return right.get();
   }
 
-  bool LeftChildProcessed() const {
-    return left_child_processed;
+  /// Count down the children whose subtrees are still growing, the caller that completes the last one returns true.
+  /// The count releases what was done in the subtree of each child to the caller that completes the node.
+  bool FinishChild() {
+    return num_pending_children.fetch_sub(1, std::memory_order_acq_rel) == 1;
   }
 
-  bool RightChildProcessed() const {
-    return right_child_processed;
-  }
-
-  void ProcessedLeft() {
-    left_child_processed = true;
-  }
-
-  void ProcessedRight() {
-    right_child_processed = true;
+  Subdataset *Subset() {
+    return subset.get();
   }
 
-  Subdataset *Subset() {
+  const Subdataset *Subset() const {
     return subset.get();
   }
 
   void SpawnChildren(const Dataset *dataset) {
+    num_pending_children = 2;
     left.reset(new TreeNode(IsLeftChildType, this));
     right.reset(new TreeNode(IsRightChildType, this));
     subset->Partition(dataset->Features(split_info->feature_idx), split_info.get(), left->subset, right->subset);
@@ -110,18 +173,25 @@ class TreeNode {
  private:
   uint32_t type;
   uint32_t depth;
+  uint64_t key;
+  uint32_t leaf_idx;
   TreeNode *parent;
   std::unique_ptr<TreeNode> left;
   std::unique_ptr<TreeNode> right;
-  bool left_child_processed;
-  bool right_child_processed;
+  std::atomic<uint32_t> num_pending_children;
   std::unique_ptr<Subdataset> subset;
   std::unique_ptr<SplitInfo> split_info;
+  std::vector<SplitInfo> candidates;
+  std::vector<std::unique_ptr<BinRangeSplit>> range_splits;
+  std::atomic<uint32_t> num_pending_candidates;
+  std::atomic<double> best_candidate_gain;
   std::unique_ptr<NodeStats> stats;
 
   TreeNode(uint32_t type,
            TreeNode *parent):
-    type(type), depth(parent->depth + 1), parent(parent), left(nullptr), right(nullptr), left_child_processed(false),
-    right_child_processed(false), subset(nullptr), split_info(nullptr), stats(nullptr) {}
+    type(type), depth(parent->depth + 1), key(Random::ChildKey(parent->key, type == IsRightChildType)), leaf_idx(0),
+    parent(parent), left(nullptr), right(nullptr), num_pending_children(0),
+    subset(nullptr), split_info(nullptr), candidates(), range_splits(),
+    num_pending_candidates(0), best_candidate_gain(0.0), stats(nullptr) {}
 };
 #endif
\ No newline at end of file
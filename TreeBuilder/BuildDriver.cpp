@@ -0,0 +1,193 @@
+
+#include "BuildDriver.h"
+#include "../Tree/StoredTree.h"
+#include "../Util/Numa.h"
+
+BuildDriver::BuildDriver(const TreeParams &params,
+                         uint32_t num_workers):
+  params(params), jobs(), policy(MakeSchedulingPolicy(LocalFirst, params)), num_workers(num_workers),
+  dataset(nullptr), records(), stats(), tracing(false), trace() {}
+
+void BuildDriver::LoadDataset(const Dataset *dataset) {
+  this->dataset = dataset;
+}
+
+void BuildDriver::SetSchedulingPolicy(uint32_t policy_id) {
+  policy = MakeSchedulingPolicy(policy_id, params);
+}
+
+void BuildDriver::SetTracing(bool tracing) {
+  this->tracing = tracing;
+}
+
+const SchedulerStats &BuildDriver::Stats() const {
+  return stats;
+}
+
+void BuildDriver::WriteTrace(std::ostream &out) const {
+  trace.WriteJson(out);
+}
+
+void BuildDriver::StartBuild() {
+  jobs.Init(num_workers);
+  records.assign(num_workers, WorkerRecord{SchedulerStats(), 0});
+  trace = BuildTrace();
+  if (tracing)
+    trace.Init(num_workers, NumTraceEventsPerWorker);
+}
+
+void BuildDriver::RunWorkers() {
+  ThreadPool::GetInstance().Run(num_workers, [this](uint32_t worker_idx) {
+    Run(worker_idx);
+  });
+}
+
+void BuildDriver::FinishBuild(uint64_t begin) {
+  stats = SchedulerStats();
+  for (const auto &record: records)
+    stats.Merge(record.stats);
+  stats.worker_stats.resize(num_workers);
+  for (uint32_t worker_idx = 0; worker_idx != num_workers; ++worker_idx) {
+    SchedulerStats::WorkerStats &worker_stats = stats.worker_stats[worker_idx];
+    worker_stats.num_jobs = records[worker_idx].num_jobs;
+    worker_stats.num_steals = jobs.NumSteals(worker_idx);
+    worker_stats.num_lane_polls = jobs.NumLanePolls(worker_idx);
+    worker_stats.spin_time = jobs.SpinTime(worker_idx);
+    worker_stats.parked_time = jobs.ParkedTime(worker_idx);
+  }
+  records.clear();
+  stats.build_time = 1e-9 * (SchedulerStats::Now() - begin);
+}
+
+void BuildDriver::Run(uint32_t worker_idx) {
+  Job job = Job::IdleJob();
+  bool finished = false;
+  jobs.SetNode(worker_idx, Numa::ThreadNode());
+  WorkerRecord &record = records[worker_idx];
+  while (!finished) {
+    bool has_feature = job.type == Job::FindSplitOnOneFeature || job.type == Job::FindSplitOnBinRange;
+    BuildTrace::Event event = StartEvent(job.type, job.node, has_feature? job.feature_idx : BuildTrace::NoFeature);
+    if (job.type != Job::Idle)
+      record.stats.job_stats[job.type].total_wait_nanoseconds += event.begin - job.offer_time;
+    TreeBuilder *builder = (job.type != Job::Idle)? Builder(job.tree_id) : nullptr;
+    if (job.type == Job::SetupRoot) {
+      Offer(Job::InitSplitJob(builder->SetupRoot(), job.tree_id), worker_idx);
+    } else if (job.type == Job::InitSplit) {
+      switch (builder->InitSplit(job.node)) {
+        case Job::MakeLeaf:
+          MakeLeafAndCheck(job, worker_idx);
+          break;
+        case Job::FindSplitOnAllFeatures: {
+          BuildTrace::Event search_event = StartEvent(Job::FindSplitOnAllFeatures, job.node, BuildTrace::NoFeature);
+          builder->FindSplitOnAllFeatures(job.node, worker_idx);
+          AddTime(worker_idx, search_event);
+          SplitOrMakeLeaf(job, worker_idx);
+        }
+          break;
+        case Job::FindSplitOnOneFeature: {
+          auto feature_iters = builder->GetFeatureSet(job.node, worker_idx);
+          uint32_t candidate_idx = 0;
+          for (auto iter = feature_iters.first; iter != feature_iters.second; ++iter)
+            Offer(Job::FindSplitOnOneFeatureJob(job.node, *iter, candidate_idx++, job.tree_id), worker_idx);
+        }
+      }
+    } else if (job.type == Job::FindSplitOnOneFeature) {
+      switch (builder->FindSplitOnOneFeature(job.feature_idx, job.candidate_idx, job.node, worker_idx)) {
+        case Job::DoSplit:
+          SplitOrMakeLeaf(job, worker_idx);
+          break;
+        case Job::FindSplitOnBinRange: {
+          uint32_t num_ranges = job.node->RangeSplit(job.candidate_idx)->num_ranges;
+          for (uint32_t range_idx = 0; range_idx != num_ranges; ++range_idx)
+            Offer(Job::FindSplitOnBinRangeJob(job.node, job.feature_idx, job.candidate_idx, range_idx, job.tree_id),
+                  worker_idx);
+        }
+      }
+    } else if (job.type == Job::FindSplitOnBinRange) {
+      if (builder->FindSplitOnBinRange(job.feature_idx, job.candidate_idx, job.range_idx, job.node, worker_idx))
+        SplitOrMakeLeaf(job, worker_idx);
+    } else if (job.type == Job::DoSplit) {
+      if (builder->DoSplit(job.node)) {
+        if (!job.node->Parent())
+          LeaveRoot(job.tree_id);
+        Offer(Job::InitSplitJob(job.node->Left(), job.tree_id), worker_idx);
+        Offer(Job::InitSplitJob(job.node->Right(), job.tree_id), worker_idx);
+      } else {
+        MakeLeafAndCheck(job, worker_idx);
+      }
+    }
+    if (job.type != Job::Idle) {
+      AddTime(worker_idx, event);
+      if (++record.num_jobs % NumJobsPerQueueDepthSample == 0) {
+        uint32_t depth = jobs.Depth();
+        record.stats.queue_depths.push_back(depth);
+        SampleQueueDepth(depth, worker_idx);
+      }
+    }
+    finished = jobs.Poll(worker_idx, job);
+  }
+}
+
+/// The scheduling policy picks the jobs for the priority lane and ranks them,
+/// any other job stays with the worker that created it
+void BuildDriver::Offer(const Job &job,
+                        uint32_t worker_idx) {
+  Job queued_job = job;
+  queued_job.offer_time = SchedulerStats::Now();
+  if (policy->ToLane(job)) {
+    queued_job.priority = policy->Priority(job);
+    jobs.Offer(queued_job);
+  } else {
+    jobs.Push(worker_idx, queued_job);
+  }
+}
+
+/// The worker that completes a root writes its tree out
+void BuildDriver::MakeLeafAndCheck(const Job &job,
+                                   uint32_t worker_idx) {
+  if (!job.node->Parent())
+    LeaveRoot(job.tree_id);
+  TreeBuilder *builder = Builder(job.tree_id);
+  BuildTrace::Event event = StartEvent(Job::MakeLeaf, job.node, BuildTrace::NoFeature);
+  bool completes_tree = builder->MakeLeaf(job.node);
+  AddTime(worker_idx, event);
+  if (!completes_tree)
+    return;
+  event = StartEvent(Job::WriteToTree, nullptr, BuildTrace::NoFeature);
+  builder->WriteToTree(Tree(job.tree_id));
+  AddTime(worker_idx, event);
+  FinishTree(job.tree_id, worker_idx);
+}
+
+void BuildDriver::SplitOrMakeLeaf(const Job &job,
+                                  uint32_t worker_idx) {
+  if (job.node->Split()->type == IsLeaf) {
+    MakeLeafAndCheck(job, worker_idx);
+  } else {
+    Offer(Job::DoSplitJob(job.node, job.tree_id), worker_idx);
+  }
+}
+
+/// The node is described before the job runs, a leaf or a split node drops its subset on the way.
+/// Without tracing only the start time is taken.
+BuildTrace::Event BuildDriver::StartEvent(uint32_t type,
+                                          const TreeNode *node,
+                                          uint32_t feature_idx) const {
+  BuildTrace::Event event = {SchedulerStats::Now(), 0, type, 0, 0, feature_idx};
+  if (tracing && node) {
+    event.depth = node->Depth();
+    event.size = node->Size();
+  }
+  return event;
+}
+
+void BuildDriver::AddTime(uint32_t worker_idx,
+                          const BuildTrace::Event &event) {
+  uint64_t end = SchedulerStats::Now();
+  records[worker_idx].stats.job_stats[event.type].Add(end - event.begin);
+  if (tracing) {
+    BuildTrace::Event traced_event = event;
+    traced_event.end = end;
+    trace.Add(worker_idx, traced_event);
+  }
+}
@@ -0,0 +1,81 @@
+
+#ifndef DECISIONTREE_BUILDDRIVER_H
+#define DECISIONTREE_BUILDDRIVER_H
+
+#include <cstdint>
+#include <ostream>
+#include "TreeBuilder.h"
+#include "../Parallel/BuildTrace.h"
+#include "../Parallel/JobQueue.h"
+#include "../Parallel/SchedulerStats.h"
+#include "../Parallel/SchedulingPolicy.h"
+#include "../Parallel/ThreadPool.h"
+
+/// The workers of a build, shared by the drivers of one tree and of a whole forest: they take jobs from the queue,
+/// run them on the builder of the tree the job belongs to, offer the jobs that follow, and count what they do.
+/// A driver says which builder and tree a job belongs to and what happens once a tree is done.
+class BuildDriver {
+ public:
+  BuildDriver(const TreeParams &params,
+              uint32_t num_workers);
+  virtual ~BuildDriver() = default;
+  void LoadDataset(const Dataset *dataset);
+  void SetSchedulingPolicy(uint32_t policy_id);
+  /// Records a timeline of the jobs of each build, off by default
+  void SetTracing(bool tracing);
+  void Run(uint32_t worker_idx);
+  /// Counters of the last build
+  const SchedulerStats &Stats() const;
+  /// Timeline of the last build in the Chrome trace event format, empty unless tracing is on
+  void WriteTrace(std::ostream &out) const;
+ protected:
+  const TreeParams params;
+  JobQueue<Job> jobs;
+  std::unique_ptr<SchedulingPolicy> policy;
+  uint32_t num_workers;
+  const Dataset *dataset;
+
+  /// Set the queue, the worker records and the trace up for a build
+  void StartBuild();
+  /// Run the workers until the queue is finished
+  void RunWorkers();
+  /// Merge the worker records into the stats of the build
+  void FinishBuild(uint64_t begin);
+  void Offer(const Job &job,
+             uint32_t worker_idx);
+
+  virtual TreeBuilder *Builder(uint32_t tree_id) = 0;
+  virtual StoredTree *Tree(uint32_t tree_id) = 0;
+  /// Called with the id of a tree once its root is split or made a leaf
+  virtual void LeaveRoot(uint32_t) {}
+  /// Called by the worker that has written a tree out
+  virtual void FinishTree(uint32_t tree_id,
+                          uint32_t worker_idx) = 0;
+  /// Called with every queue depth a worker samples and the index of the worker
+  virtual void SampleQueueDepth(uint32_t,
+                                uint32_t) {}
+
+ private:
+  /// Counted by each worker on its own during a build, then merged into stats
+  struct WorkerRecord {
+    SchedulerStats stats;
+    uint64_t num_jobs;
+  };
+
+  std::vector<WorkerRecord> records;
+  SchedulerStats stats;
+  bool tracing;
+  BuildTrace trace;
+
+  void MakeLeafAndCheck(const Job &job,
+                        uint32_t worker_idx);
+  void SplitOrMakeLeaf(const Job &job,
+                       uint32_t worker_idx);
+  BuildTrace::Event StartEvent(uint32_t type,
+                               const TreeNode *node,
+                               uint32_t feature_idx) const;
+  void AddTime(uint32_t worker_idx,
+               const BuildTrace::Event &event);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include "ForestBuildDriver.h"
+#include "../Tree/StoredTree.h"
+
+ForestBuildDriver::ForestBuildDriver(const TreeParams &params,
+                                     uint32_t num_workers):
+  BuildDriver(params, num_workers), num_trees(0), start_tree(), finish_tree(), builders(), trees(), start_mut(),
+  num_trees_to_build(0), next_tree_id(0), num_trees_in_flight(0), num_trees_at_root(0), num_trees_done(0),
+  max_num_trees_in_flight(0) {}
+
+void ForestBuildDriver::LoadTrees(uint32_t num_trees,
+                                  const std::function<TreeSlot(uint32_t)> &start_tree,
+                                  const std::function<void(uint32_t)> &finish_tree) {
+  this->num_trees = num_trees;
+  this->start_tree = start_tree;
+  this->finish_tree = finish_tree;
+}
+
+void ForestBuildDriver::Build() {
+  uint64_t begin = SchedulerStats::Now();
+  num_trees_to_build = num_trees;
+  if (num_trees == 0)
+    return;
+  builders.clear();
+  builders.resize(num_trees);
+  trees.assign(num_trees, nullptr);
+  next_tree_id = 0;
+  num_trees_in_flight = 0;
+  num_trees_at_root = 0;
+  num_trees_done = 0;
+  max_num_trees_in_flight = 0;
+  StartBuild();
+  jobs.SetIdleHandler([this](uint32_t worker_idx) {
+    if (WantsTree())
+      StartTree(worker_idx);
+  });
+  for (uint32_t tree_idx = 0; tree_idx != std::min(NumTreesAtForestStart, num_workers); ++tree_idx)
+    StartTree(0);
+  RunWorkers();
+  builders.clear();
+  FinishBuild(begin);
+}
+
+uint32_t ForestBuildDriver::MaxNumTreesInFlight() const {
+  return max_num_trees_in_flight;
+}
+
+/// The caller's own tree is started but not yet counted as done, so the count of done trees is still to reach the
+/// new target, and the worker that reaches it ends the build
+void ForestBuildDriver::StopStartingTrees() {
+  std::lock_guard<std::mutex> lock(start_mut);
+  num_trees_to_build = next_tree_id.load();
+}
+
+uint32_t ForestBuildDriver::NumTreesBuilt() const {
+  return num_trees_to_build;
+}
+
+/// Another tree is worth starting if there is one left, a worker for it, and no tree is still at its root
+bool ForestBuildDriver::WantsTree() const {
+  return next_tree_id.load(std::memory_order_relaxed) != num_trees_to_build.load(std::memory_order_relaxed) &&
+         num_trees_in_flight.load(std::memory_order_relaxed) < num_workers &&
+         num_trees_at_root.load(std::memory_order_relaxed) == 0;
+}
+
+bool ForestBuildDriver::StartTree(uint32_t worker_idx) {
+  std::lock_guard<std::mutex> lock(start_mut);
+  uint32_t tree_id = next_tree_id;
+  if (tree_id == num_trees_to_build || num_trees_in_flight == num_workers)
+    return false;
+  TreeSlot slot = start_tree(tree_id);
+  trees[tree_id] = slot.tree;
+  // seeded as the trainer of tree i would be when trees are built in turns
+  builders[tree_id] = std::make_unique<TreeBuilder>(
+    TreeParams(params.cost_function, params.min_leaf_node, params.min_split_node, params.max_depth,
+               params.max_num_nodes, params.num_features_for_split, params.random_state + tree_id),
+    num_workers);
+  builders[tree_id]->LoadSampleWeights(slot.sample_weights);
+  builders[tree_id]->SetLeafHandler(slot.leaf_handler, slot.route_out_of_bag);
+  builders[tree_id]->LoadDataSet(dataset);
+  ++num_trees_at_root;
+  max_num_trees_in_flight = std::max(max_num_trees_in_flight, ++num_trees_in_flight);
+  next_tree_id = tree_id + 1;
+  Offer(Job::SetupRootJob(tree_id), worker_idx);
+  return true;
+}
+
+TreeBuilder *ForestBuildDriver::Builder(uint32_t tree_id) {
+  return builders[tree_id].get();
+}
+
+StoredTree *ForestBuildDriver::Tree(uint32_t tree_id) {
+  return trees[tree_id];
+}
+
+void ForestBuildDriver::LeaveRoot(uint32_t) {
+  --num_trees_at_root;
+}
+
+/// The worker that writes a tree out frees the slot for the next tree, the worker that completes the last tree ends
+/// the build
+void ForestBuildDriver::FinishTree(uint32_t tree_id,
+                                   uint32_t worker_idx) {
+  builders[tree_id].reset();
+  finish_tree(tree_id);
+  --num_trees_in_flight;
+  if (++num_trees_done == num_trees_to_build) {
+    jobs.SetFinish();
+  } else {
+    StartTree(worker_idx);
+  }
+}
+
+/// A shallow queue means the trees in flight no longer keep every worker busy
+void ForestBuildDriver::SampleQueueDepth(uint32_t depth,
+                                         uint32_t worker_idx) {
+  if (depth < num_workers && WantsTree())
+    StartTree(worker_idx);
+}
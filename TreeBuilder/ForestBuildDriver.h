@@ -0,0 +1,68 @@
+#ifndef DECISIONTREE_FORESTBUILDDRIVER_H
+#define DECISIONTREE_FORESTBUILDDRIVER_H
+
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include "BuildDriver.h"
+
+/// Builds the trees of a forest on one job queue, told apart by Job::tree_id. All workers start on the top levels
+/// of NumTreesAtForestStart trees. Another tree starts when the sampled queue depth drops below one job per worker
+/// or a worker has spun for a job until it would park, so workers move to new trees as the frontiers of the trees
+/// in flight thin out. No tree starts while one is still at its root, whose split keeps every worker busy soon.
+class ForestBuildDriver: public BuildDriver {
+ public:
+  /// A tree about to start, the tree to write to and the weights to build it on, which must outlive the build,
+  /// and what its builder does with each leaf, see TreeBuilder::SetLeafHandler
+  struct TreeSlot {
+    StoredTree *tree;
+    const vec_uint8_t *sample_weights;
+    std::function<void(const TreeNode *)> leaf_handler;
+    bool route_out_of_bag;
+  };
+
+  ForestBuildDriver(const TreeParams &params,
+                    uint32_t num_workers);
+  /// start_tree is called for trees 0, 1, ... in order, one call at a time, by the worker that starts the tree.
+  /// finish_tree is called by the worker that writes a tree out, trees may finish out of order and at the same time.
+  void LoadTrees(uint32_t num_trees,
+                 const std::function<TreeSlot(uint32_t)> &start_tree,
+                 const std::function<void(uint32_t)> &finish_tree);
+  void Build();
+  /// Most trees the last build had in flight at once
+  uint32_t MaxNumTreesInFlight() const;
+  /// Start no more trees, the build ends once the trees already started are done. Only to be called from finish_tree.
+  void StopStartingTrees();
+  /// Trees built by the last build, trees 0, 1, ... fewer than loaded if it was stopped
+  uint32_t NumTreesBuilt() const;
+ private:
+  uint32_t num_trees;
+  std::function<TreeSlot(uint32_t)> start_tree;
+  std::function<void(uint32_t)> finish_tree;
+
+  /// A builder lives from the start of its tree until the tree is written out
+  std::vector<std::unique_ptr<TreeBuilder>> builders;
+  std::vector<StoredTree *> trees;
+
+  /// Starting trees is serialized, the counts are read without the lock to decide whether to try
+  std::mutex start_mut;
+  std::atomic<uint32_t> num_trees_to_build;
+  std::atomic<uint32_t> next_tree_id;
+  std::atomic<uint32_t> num_trees_in_flight;
+  std::atomic<uint32_t> num_trees_at_root;
+  std::atomic<uint32_t> num_trees_done;
+  uint32_t max_num_trees_in_flight;
+
+  bool StartTree(uint32_t worker_idx);
+  bool WantsTree() const;
+  TreeBuilder *Builder(uint32_t tree_id) override;
+  StoredTree *Tree(uint32_t tree_id) override;
+  void LeaveRoot(uint32_t tree_id) override;
+  void FinishTree(uint32_t tree_id,
+                  uint32_t worker_idx) override;
+  void SampleQueueDepth(uint32_t depth,
+                        uint32_t worker_idx) override;
+};
+
+#endif
@@ -3,12 +3,10 @@
 #define DECISIONTREE_TREEBUILDDRIVER_H
 
 #include <cstdint>
-#include <thread>
-#include <condition_variable>
-#include "TreeBuilder.h"
-#include "../Parallel/JobQueue.h"
+#include "BuildDriver.h"
 
-class SingleTreeBuildDriver {
+/// Builds one tree, every job belongs to the builder of this driver
+class SingleTreeBuildDriver: public BuildDriver {
  public:
   SingleTreeBuildDriver(uint32_t cost_function,
                         uint32_t min_leaf_node,
@@ -18,25 +16,25 @@ class SingleTreeBuildDriver {
                         uint32_t num_workers,
                         uint32_t max_num_nodes,
                         uint32_t max_depth);
-  void LoadDataset(const Dataset *dataset);
+  /// Weights of the tree to build, nullptr for the weights of the dataset
+  void LoadSampleWeights(const vec_uint8_t *sample_weights);
+  /// See TreeBuilder::SetLeafHandler
+  void SetLeafHandler(const std::function<void(const TreeNode *)> &leaf_handler,
+                      bool route_out_of_bag);
+  /// See TreeBuilder::LoadLeafIds
+  void LoadLeafIds(vec_int32_t *leaf_ids);
   void LoadTree(StoredTree *tree);
   void Build();
-  void Run();
  private:
+  /// The builder, with its splitter, and the job queue belong to this build alone,
+  /// so that any number of builds can run side by side
   TreeBuilder builder;
-  uint32_t num_workers;
-  const Dataset *dataset;
   StoredTree *tree;
 
-  bool finish;
-
-  std::mutex update_mut;
-  std::mutex finish_mut;
-  std::condition_variable cv_finish;
-
-  void MakeLeafAndCheck(const Job &job,
-                        JobQueue<Job> &jobs);
-  void SplitOrMakeLeaf(const Job &job, JobQueue<Job> &jobs);
+  TreeBuilder *Builder(uint32_t tree_id) override;
+  StoredTree *Tree(uint32_t tree_id) override;
+  void FinishTree(uint32_t tree_id,
+                  uint32_t worker_idx) override;
 };
 
 #endif
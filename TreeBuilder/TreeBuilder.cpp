@@ -1,7 +1,6 @@
 
 #include "TreeBuilder.h"
 #include "../Util/Random.h"
-#include "../Util/Cost.h"
 #include "../Tree/StoredTree.h"
 #include "../Parallel/Job.h"
 
@@ -11,30 +10,52 @@ TreeBuilder::TreeBuilder(uint32_t cost_function,
                          uint32_t max_depth,
                          uint32_t max_num_nodes,
                          uint32_t num_features_for_split,
-                         uint32_t random_state):
+                         uint32_t random_state,
+                         uint32_t num_workers):
   params(cost_function, min_leaf_node, min_split_node, max_depth, max_num_nodes, num_features_for_split, random_state),
-  dataset(nullptr), presorted_indices(nullptr), root(nullptr),
-  cell_count(0), leaf_count(0), finish(false) {
-  Random::Init(random_state);
-}
+  num_workers(num_workers), dataset(nullptr), presorted_indices(nullptr), sample_weights(nullptr), leaf_handler(),
+  route_out_of_bag(false), leaf_ids(nullptr), splitter(nullptr), feature_sets(), root(nullptr),
+  cell_count(0), leaf_count(0), scan_count(0), skipped_scan_count(0) {}
 
-TreeBuilder::TreeBuilder(const TreeParams &params):
-  params(params), dataset(nullptr), presorted_indices(nullptr), root(nullptr),
-  cell_count(0), leaf_count(0), finish(false) {
-  Random::Init(params.random_state);
-}
+TreeBuilder::TreeBuilder(const TreeParams &params,
+                         uint32_t num_workers):
+  params(params), num_workers(num_workers), dataset(nullptr), presorted_indices(nullptr), sample_weights(nullptr),
+  leaf_handler(), route_out_of_bag(false), leaf_ids(nullptr), splitter(nullptr), feature_sets(), root(nullptr),
+  cell_count(0), leaf_count(0), scan_count(0), skipped_scan_count(0) {}
 
 TreeBuilder::~TreeBuilder() = default;
 
 void TreeBuilder::LoadDataSet(const Dataset *dataset, const vec_vec_uint32_t *presorted_indices) {
   this->dataset = dataset;
-  if (params.cost_function == Entropy)
-    Cost::Init(params.cost_function, this->dataset->ClassWeights(), this->dataset->Meta().wnum_samples);
   this->presorted_indices = presorted_indices;
+  splitter = std::make_unique<Splitter>(dataset, params, num_workers);
+  feature_sets.assign(num_workers, vec_uint32_t(dataset->Meta().num_features));
+  for (auto &feature_set: feature_sets)
+    std::iota(feature_set.begin(), feature_set.end(), 0);
+}
+
+void TreeBuilder::LoadSampleWeights(const vec_uint8_t *sample_weights) {
+  this->sample_weights = sample_weights;
+}
+
+void TreeBuilder::SetLeafHandler(const std::function<void(const TreeNode *)> &leaf_handler,
+                                 bool route_out_of_bag) {
+  this->leaf_handler = leaf_handler;
+  this->route_out_of_bag = route_out_of_bag;
+}
+
+void TreeBuilder::LoadLeafIds(vec_int32_t *leaf_ids) {
+  this->leaf_ids = leaf_ids;
 }
 
 TreeNode *TreeBuilder::SetupRoot() {
-  root = std::make_unique<TreeNode>(dataset);
+  if (sample_weights) {
+    root = std::make_unique<TreeNode>(dataset, *sample_weights, route_out_of_bag);
+  } else {
+    root = std::make_unique<TreeNode>(dataset, dataset->SampleWeights(), route_out_of_bag);
+  }
+  if (leaf_ids)
+    leaf_ids->assign(dataset->Meta().size, -1);
   return root.get();
 }
 
@@ -46,40 +67,62 @@ uint32_t TreeBuilder::InitSplit(TreeNode *node) {
     return Job::MakeLeaf;
   if (params.cost_function != Variance && node->Stats()->WNumSamples() < params.min_split_node)
     return Job::MakeLeaf;
-  return (node->Size() <= MaxSizeForSerialSplit)? Job::FindSplitOnAllFeatures : Job::FindSplitOnOneFeature;
+  if (node->Size() <= MaxSizeForSerialSplit)
+    return Job::FindSplitOnAllFeatures;
+  node->InitSplitInfo(params.num_features_for_split);
+  return Job::FindSplitOnOneFeature;
 }
 
-std::pair<vec_uint32_t::iterator, vec_uint32_t::iterator> TreeBuilder::GetFeatureSet() {
-  static thread_local vec_uint32_t feature_set;
-  if (feature_set.empty()) {
-    feature_set = std::vector<uint32_t>(dataset->Meta().num_features);
-    std::iota(feature_set.begin(), feature_set.end(), 0);
-  }
-  Random::PartialShuffle(dataset->Meta().num_features, params.num_features_for_split, feature_set);
+/// The features stay valid until the worker draws its next feature set. The draw depends on the node alone,
+/// not on the worker or on what the worker drew before.
+std::pair<vec_uint32_t::iterator, vec_uint32_t::iterator> TreeBuilder::GetFeatureSet(const TreeNode *node,
+                                                                                    uint32_t worker_idx) {
+  vec_uint32_t &feature_set = feature_sets[worker_idx];
+  std::iota(feature_set.begin(), feature_set.end(), 0);
+  Philox generator(params.random_state, Random::Stream(node->Key(), 0));
+  Random::PartialShuffle(dataset->Meta().num_features, params.num_features_for_split, feature_set, generator);
   return {feature_set.begin(), feature_set.begin() + params.num_features_for_split};
 }
 
-void TreeBuilder::FindSplitOnAllFeatures(TreeNode *node) {
+void TreeBuilder::FindSplitOnAllFeatures(TreeNode *node,
+                                         uint32_t worker_idx) {
   node->InitSplitInfo();
-  const auto feature_iters = GetFeatureSet();
+  const auto feature_iters = GetFeatureSet(node, worker_idx);
   for (auto iter = feature_iters.first; iter != feature_iters.second; ++iter)
-    FindSplitOnOneFeature(*iter, node);
+    SplitOnFeature(*iter, node, node->Split()->gain + FloatError, worker_idx, node->Split());
   node->Split()->FinishUpdate();
 }
 
-void TreeBuilder::FindSplitOnOneFeature(uint32_t feature_idx,
-                                        TreeNode *node) {
-  if (!node->Split())
-    node->InitSplitInfo();
-  uint32_t feature_type = dataset->FeatureType(feature_idx);
-  bool to_delete_sorted_idx = PrepareSubset(feature_type, feature_idx, node);
-  Splitter &splitter = Splitter::GetInstance(dataset, params);
-  splitter.Split(feature_idx, feature_type, dataset, node);
-  if (to_delete_sorted_idx) node->DiscardSortedIdx(feature_idx);
+/// Return the next step of the node:
+/// FindSplitOnBinRange if the search was cut into bin ranges to be offered as jobs,
+/// DoSplit if this was the last candidate and the split of the node is decided,
+/// Idle if other candidates are still pending.
+uint32_t TreeBuilder::FindSplitOnOneFeature(uint32_t feature_idx,
+                                            uint32_t candidate_idx,
+                                            TreeNode *node,
+                                            uint32_t worker_idx) {
+  // candidates are reduced in order and the earlier one wins a tie, only a candidate losing to the best one
+  // finished so far by more than FloatError is sure not to be taken
+  double gain_to_beat = std::max(node->BestCandidateGain() - FloatError, FloatError);
+  SplitOnFeature(feature_idx, node, gain_to_beat, worker_idx, node->Candidate(candidate_idx),
+                 &node->RangeSplit(candidate_idx));
+  if (node->RangeSplit(candidate_idx))
+    return Job::FindSplitOnBinRange;
+  node->PublishCandidateGain(node->Candidate(candidate_idx)->gain);
+  return (node->FinishCandidate())? Job::DoSplit : Job::Idle;
 }
 
-bool TreeBuilder::FindSplitFinished(TreeNode *node) {
-  return node->Split()->num_updates == params.num_features_for_split;
+bool TreeBuilder::FindSplitOnBinRange(uint32_t feature_idx,
+                                      uint32_t candidate_idx,
+                                      uint32_t range_idx,
+                                      TreeNode *node,
+                                      uint32_t worker_idx) {
+  if (!splitter->SplitBinRange(worker_idx, feature_idx, range_idx, dataset, node,
+                               node->RangeSplit(candidate_idx).get(), node->Candidate(candidate_idx)))
+    return false;
+  node->DiscardRangeSplit(candidate_idx);
+  node->PublishCandidateGain(node->Candidate(candidate_idx)->gain);
+  return node->FinishCandidate();
 }
 
 bool TreeBuilder::DoSplit(TreeNode *node) {
@@ -95,13 +138,18 @@ bool TreeBuilder::DoSplit(TreeNode *node) {
 }
 
 bool TreeBuilder::MakeLeaf(TreeNode *node) {
-  ++leaf_count;
-  node->ProcessedLeft();
-  node->ProcessedRight();
+  node->SetLeafIdx(leaf_count++);
+  if (leaf_ids)
+    for (const auto sample_id: node->Subset()->SampleIds())
+      (*leaf_ids)[sample_id] = node->LeafIdx();
+  if (leaf_handler)
+    leaf_handler(node);
   node->DiscardTemporaryElements();
-  node->DiscardSubset();
-  finish = UpdateStatus(node);
-  return finish;
+  return CompleteSubtree(node);
+}
+
+const TreeParams &TreeBuilder::Params() const {
+  return params;
 }
 
 void TreeBuilder::WriteToTree(StoredTree *tree) {
@@ -117,9 +165,12 @@ void TreeBuilder::WriteToTree(StoredTree *tree) {
   };
 
   tree->Init(*dataset, cell_count, leaf_count);
+  tree->num_scans = scan_count;
+  tree->num_skipped_scans = skipped_scan_count;
 
   std::vector<NumberedNode> stack;
   stack.reserve(cell_count + leaf_count);
+  vec_int32_t tree_leaf_ids(leaf_ids? leaf_count.load() : 0);
 
   int32_t cell_top = 0;
   int32_t leaf_top = 0;
@@ -129,6 +180,8 @@ void TreeBuilder::WriteToTree(StoredTree *tree) {
     NumberedNode &curr = stack.back();
     if (curr.next == IsLeftChildType) {
       if (!curr.node->Split() || curr.node->Split()->type == IsLeaf) {
+        if (leaf_ids)
+          tree_leaf_ids[curr.node->LeafIdx()] = leaf_top;
         tree->WriteToLeaf(curr.node, leaf_top++, curr.parent_id);
         stack.pop_back();
       } else {
@@ -146,10 +199,35 @@ void TreeBuilder::WriteToTree(StoredTree *tree) {
   }
 
   tree->CleanUp();
+  if (leaf_ids)
+    for (auto &leaf_id: *leaf_ids)
+      if (leaf_id >= 0)
+        leaf_id = tree_leaf_ids[leaf_id];
 
   root.reset();
 }
 
+/// Skip the scan of a feature that cannot reach gain_to_beat, below which its split would not be taken anyway.
+/// No split gains more than the cost of the node, which decides before the subset is even prepared,
+/// the splitter then tightens the bound for discrete features from their bin histograms.
+void TreeBuilder::SplitOnFeature(uint32_t feature_idx,
+                                 TreeNode *node,
+                                 double gain_to_beat,
+                                 uint32_t worker_idx,
+                                 SplitInfo *split_info,
+                                 std::unique_ptr<BinRangeSplit> *range_split) {
+  ++scan_count;
+  if (SplitInfo::CannotBeat(node->Stats()->Cost(), gain_to_beat, node->Stats()->Cost())) {
+    ++skipped_scan_count;
+    return;
+  }
+  uint32_t feature_type = dataset->FeatureType(feature_idx);
+  bool to_delete_sorted_idx = PrepareSubset(feature_type, feature_idx, node);
+  if (!splitter->Split(worker_idx, feature_idx, feature_type, dataset, node, gain_to_beat, split_info, range_split))
+    ++skipped_scan_count;
+  if (to_delete_sorted_idx) node->DiscardSortedIdx(feature_idx);
+}
+
 bool TreeBuilder::PrepareSubset(uint32_t feature_type,
                                 uint32_t feature_idx,
                                 TreeNode *node) {
@@ -182,23 +260,16 @@ TreeNode *TreeBuilder::LookForAncestor(uint32_t feature_idx,
   return nullptr;
 }
 
-bool TreeBuilder::UpdateStatus(TreeNode *node) {
-  std::unique_lock<std::mutex> lock(update_mut);
-  while (node) {
+/// Free the subset of a completed subtree, and go up as long as it completes the subtree of the parent.
+/// Descendants look for presorted indices in the subsets of their ancestors, which are only freed here,
+/// once no node below them can still be growing.
+bool TreeBuilder::CompleteSubtree(TreeNode *node) {
+  while (true) {
     node->DiscardSubset();
     if (node->IsRoot())
       return true;
-    if (node->IsLeftChild()) {
-      node->Parent()->ProcessedLeft();
-      if (!node->Parent()->RightChildProcessed())
-        return false;
-    }
-    if (node->IsRightChild()) {
-      node->Parent()->ProcessedRight();
-      if (!node->Parent()->LeftChildProcessed())
-        return false;
-    }
     node = node->Parent();
+    if (!node->FinishChild())
+      return false;
   }
-  return true;
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 #include <memory>
 #include <atomic>
-#include <mutex>
+#include <functional>
 #include "../Generics/TypeDefs.h"
 #include "../Tree/TreeParams.h"
 #include "../Splitter/Splitter.h"
@@ -12,6 +12,8 @@
 class Dataset;
 class StoredTree;
 class TreeNode;
+class SplitInfo;
+class BinRangeSplit;
 
 class TreeBuilder {
  public:
@@ -21,38 +23,74 @@ class TreeBuilder {
               uint32_t max_depth,
               uint32_t max_num_nodes,
               uint32_t num_features_for_split,
-              uint32_t random_state);
-  explicit TreeBuilder(const TreeParams &params);
+              uint32_t random_state,
+              uint32_t num_workers);
+  TreeBuilder(const TreeParams &params,
+              uint32_t num_workers);
   ~TreeBuilder();
   void LoadDataSet(const Dataset *dataset,
                    const vec_vec_uint32_t *presorted_indices = nullptr);
+  /// Bootstrap weights of this tree, which leave the dataset untouched, nullptr for the weights of the dataset
+  void LoadSampleWeights(const vec_uint8_t *sample_weights);
+  /// leaf_handler is called with each leaf by the worker that makes it, while the subset of the leaf still holds
+  /// its sample ids, and with route_out_of_bag the ids of the samples out of the bag that reach the leaf
+  void SetLeafHandler(const std::function<void(const TreeNode *)> &leaf_handler,
+                      bool route_out_of_bag);
+  /// leaf_ids, if given, gets the leaf each sample in the bag reaches, and -1 for the samples out of the bag.
+  /// MakeLeaf marks the sample ids of each leaf with the rank of the leaf, WriteToTree renumbers them as the tree does.
+  void LoadLeafIds(vec_int32_t *leaf_ids);
   TreeNode *SetupRoot();
   uint32_t InitSplit(TreeNode *node);
-  std::pair<vec_uint32_t::iterator, vec_uint32_t::iterator> GetFeatureSet();
-  void FindSplitOnAllFeatures(TreeNode *node);
-  void FindSplitOnOneFeature(uint32_t feature_idx,
-                             TreeNode *node);
-  bool FindSplitFinished(TreeNode *node);
+  std::pair<vec_uint32_t::iterator, vec_uint32_t::iterator> GetFeatureSet(const TreeNode *node,
+                                                                          uint32_t worker_idx);
+  void FindSplitOnAllFeatures(TreeNode *node,
+                              uint32_t worker_idx);
+  uint32_t FindSplitOnOneFeature(uint32_t feature_idx,
+                                 uint32_t candidate_idx,
+                                 TreeNode *node,
+                                 uint32_t worker_idx);
+  bool FindSplitOnBinRange(uint32_t feature_idx,
+                           uint32_t candidate_idx,
+                           uint32_t range_idx,
+                           TreeNode *node,
+                           uint32_t worker_idx);
   bool DoSplit(TreeNode *node);
+  /// Whether the leaf completes the tree
   bool MakeLeaf(TreeNode *node);
   void WriteToTree(StoredTree *tree);
+  const TreeParams &Params() const;
 
  private:
   TreeParams params;
+  const uint32_t num_workers;
   const Dataset *dataset;
   const vec_vec_uint32_t *presorted_indices;
+  const vec_uint8_t *sample_weights;
+  std::function<void(const TreeNode *)> leaf_handler;
+  bool route_out_of_bag;
+  vec_int32_t *leaf_ids;
+  /// Bound to the dataset and params of this build, created when the dataset is loaded
+  std::unique_ptr<Splitter> splitter;
+  /// Feature set drawn by each worker, see GetFeatureSet
+  std::vector<vec_uint32_t> feature_sets;
   std::unique_ptr<TreeNode> root;
   std::atomic<uint32_t> cell_count;
   std::atomic<uint32_t> leaf_count;
-  std::mutex update_mut;
-  bool finish;
+  std::atomic<uint32_t> scan_count;
+  std::atomic<uint32_t> skipped_scan_count;
 
+  void SplitOnFeature(uint32_t feature_idx,
+                      TreeNode *node,
+                      double gain_to_beat,
+                      uint32_t worker_idx,
+                      SplitInfo *split_info,
+                      std::unique_ptr<BinRangeSplit> *range_split = nullptr);
   bool PrepareSubset(uint32_t feature_type,
                      uint32_t feature_idx,
                      TreeNode *node);
   TreeNode* LookForAncestor(uint32_t feature_idx,
                             TreeNode *node);
-  bool UpdateStatus(TreeNode *node);
+  bool CompleteSubtree(TreeNode *node);
 };
 
 #endif
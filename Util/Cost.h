@@ -3,39 +3,65 @@
 #define DECISIONTREE_COST_H
 
 #include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstring>
 #include "../Generics/TypeDefs.h"
 #include "../Global/GlobalConsts.h"
 
 namespace Cost {
 
-extern uint32_t cost_function;
-extern double multiplier;
-extern vec_dbl_t nlogn_table;
-
-void Init(uint32_t cost_function,
-          const vec_dbl_t &class_weights,
-          double wnum_samples);
-void ConstructNLogNTable(const vec_dbl_t &class_weights,
-                         double wnum_samples);
-void ExtendNLogNTable(double wnum_samples);
-void CleanUp();
-
-static double NLogN(double x) {
-  return (x > 0.0)? x * log2(x) : 0.0;
+/// log2 of a positive normal number without calling into libm, so that loops over it can be vectorised.
+/// x = m * 2^e with m in [sqrt(1/2), sqrt(2)), ln(m) = 2 atanh(s) with s = (m - 1) / (m + 1) and |s| < 0.172,
+/// the atanh series is truncated after s^17, which keeps the result within a few ulps of log2.
+static double FastLog2(double x) {
+  uint64_t bits;
+  memcpy(&bits, &x, sizeof(double));
+  auto exponent = static_cast<int64_t>((bits >> 52) & 0x7ff) - 1023;
+  bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+  double mantissa;
+  memcpy(&mantissa, &bits, sizeof(double));
+  // select rather than branch, the branch is unpredictable and blocks vectorisation
+  const bool above_sqrt2 = mantissa > M_SQRT2;
+  mantissa *= above_sqrt2? 0.5 : 1.0;
+  exponent += above_sqrt2;
+  const double s = (mantissa - 1.0) / (mantissa + 1.0);
+  const double s2 = s * s;
+  double series = 1.0 / 17.0;
+  series = series * s2 + 1.0 / 15.0;
+  series = series * s2 + 1.0 / 13.0;
+  series = series * s2 + 1.0 / 11.0;
+  series = series * s2 + 1.0 / 9.0;
+  series = series * s2 + 1.0 / 7.0;
+  series = series * s2 + 1.0 / 5.0;
+  series = series * s2 + 1.0 / 3.0;
+  series = series * s2 + 1.0;
+  return static_cast<double>(exponent) + 2.0 * M_LOG2E * s * series;
 }
 
-static double NLogN(uint32_t x) {
-  return nlogn_table[x];
+/// n log n of the integers below NLogNTableSize, weighted counts are integral unless class weights are not.
+/// Its size is fixed, unlike the number of samples.
+inline const vec_dbl_t &NLogNTable() {
+  static const vec_dbl_t table = [] {
+    vec_dbl_t table(NLogNTableSize, 0.0);
+    for (uint32_t idx = 1; idx != NLogNTableSize; ++idx)
+      table[idx] = idx * log2(static_cast<double>(idx));
+    return table;
+  }();
+  return table;
 }
 
-static double DeltaNLogN(double x2,
-                         double x1) {
-  return NLogN(x2) - NLogN(x1);
+/// Kept out of line, so that NLogN stays small enough to be inlined into the split finding loops
+__attribute__((noinline)) static double ComputeNLogN(double x) {
+  return (x > 0.0)? x * FastLog2(x) : 0.0;
 }
 
-static double DeltaNLogN(uint32_t x2,
-                         uint32_t x1) {
-  return NLogN(x2) - NLogN(x1);
+inline double NLogN(double x) {
+  if (x < NLogNTableSize) {
+    auto idx = static_cast<uint32_t>(x);
+    if (idx == x) return NLogNTable()[idx];
+  }
+  return ComputeNLogN(x);
 }
 
 static double GiniCost(const vec_dbl_t &histogram) {
@@ -55,7 +81,8 @@ static double EntropyCost(const vec_dbl_t &histogram) {
   return ret;
 }
 
-static double Cost(const vec_dbl_t &histogram) {
+static double Cost(uint32_t cost_function,
+                   const vec_dbl_t &histogram) {
   if (cost_function == GiniImpurity)
     return GiniCost(histogram);
   if (cost_function == Entropy)
@@ -5,9 +5,11 @@
 #include <vector>
 #include <cstdint>
 #include <cmath>
+#include <numeric>
 #include <boost/variant.hpp>
 #include "../Generics/TypeDefs.h"
 #include "../Generics/Generics.h"
+#include "../Global/GlobalConsts.h"
 
 namespace Maths {
 
@@ -86,5 +88,18 @@ static uint32_t Argmax(const vec_dbl_t &histogram) {
   return ret;
 }
 
+template<typename value_t>
+static uint32_t Argmax(const value_t *histogram,
+                       uint32_t size) {
+  uint32_t ret = 0;
+  value_t max = 0;
+  for (uint32_t idx = 0; idx != size; ++idx)
+    if (histogram[idx] > max) {
+      max = histogram[idx];
+      ret = idx;
+    }
+  return ret;
+}
+
 }
 #endif
@@ -0,0 +1,157 @@
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "Numa.h"
+
+namespace Numa {
+
+namespace {
+
+/// Nodes are numbered here from 0 in the order of their kernel ids, skipping nodes of memory only
+struct Topology {
+  vec_uint32_t node_ids;
+  vec_vec_uint32_t node_cpus;
+  vec_uint32_t cpu_nodes;
+
+  Topology():
+    node_ids(), node_cpus(), cpu_nodes() {
+    for (auto node_id: ParseList("/sys/devices/system/node/online")) {
+      vec_uint32_t cpus = ParseList("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+      if (!cpus.empty()) {
+        node_ids.push_back(node_id);
+        node_cpus.push_back(cpus);
+      }
+    }
+    if (node_cpus.empty()) {
+      node_ids.push_back(0);
+      node_cpus.emplace_back(std::max(std::thread::hardware_concurrency(), 1u));
+      for (uint32_t cpu = 0; cpu != node_cpus[0].size(); ++cpu)
+        node_cpus[0][cpu] = cpu;
+    }
+    for (uint32_t node = 0; node != node_cpus.size(); ++node)
+      for (auto cpu: node_cpus[node]) {
+        if (cpu >= cpu_nodes.size())
+          cpu_nodes.resize(cpu + 1, 0);
+        cpu_nodes[cpu] = node;
+      }
+  }
+
+  /// Lists as the kernel writes them, e.g. 0-3,8-11
+  static vec_uint32_t ParseList(const std::string &path) {
+    vec_uint32_t list;
+    std::ifstream file(path);
+    std::string range;
+    while (std::getline(file, range, ',')) {
+      std::istringstream stream(range);
+      uint32_t first = 0, last = 0;
+      char dash = 0;
+      if (!(stream >> first))
+        continue;
+      last = (stream >> dash >> last)? last : first;
+      for (uint32_t idx = first; idx <= last; ++idx)
+        list.push_back(idx);
+    }
+    return list;
+  }
+};
+
+const Topology &GetTopology() {
+  static Topology topology;
+  return topology;
+}
+
+/// Counts the pins, a thread looks its node up again once the count has moved on
+std::atomic<uint32_t> num_pins(0);
+} // namespace
+
+uint32_t NumNodes() {
+  return static_cast<uint32_t>(GetTopology().node_cpus.size());
+}
+
+const vec_uint32_t &NodeCpus(uint32_t node) {
+  return GetTopology().node_cpus[node];
+}
+
+uint32_t CurrentNode() {
+  const Topology &topology = GetTopology();
+  if (topology.node_cpus.size() == 1)
+    return 0;
+  int cpu = sched_getcpu();
+  return (cpu >= 0 && static_cast<uint32_t>(cpu) < topology.cpu_nodes.size())? topology.cpu_nodes[cpu] : 0;
+}
+
+uint32_t ThreadNode() {
+  static thread_local uint32_t node = 0;
+  static thread_local uint32_t num_pins_seen = UINT32_MAX;
+  uint32_t num_pins_now = num_pins.load(std::memory_order_acquire);
+  if (num_pins_seen != num_pins_now) {
+    node = CurrentNode();
+    num_pins_seen = num_pins_now;
+  }
+  return node;
+}
+
+uint32_t NodeOfAddress(const void *addr) {
+  const vec_uint32_t &node_ids = GetTopology().node_ids;
+  int node_id = -1;
+  if (syscall(SYS_get_mempolicy, &node_id, nullptr, 0, const_cast<void *>(addr), MPOL_F_NODE | MPOL_F_ADDR) != 0)
+    return NumNodes();
+  return static_cast<uint32_t>(std::find(node_ids.begin(), node_ids.end(), node_id) - node_ids.begin());
+}
+
+uint32_t SpreadCpu(uint32_t thread_idx) {
+  const vec_vec_uint32_t &node_cpus = GetTopology().node_cpus;
+  const vec_uint32_t &cpus = node_cpus[thread_idx % node_cpus.size()];
+  return cpus[(thread_idx / node_cpus.size()) % cpus.size()];
+}
+
+void PinToCpu(std::thread &thread,
+              uint32_t cpu) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpu_set);
+  num_pins.fetch_add(1, std::memory_order_release);
+}
+
+void RunOnNode(uint32_t node,
+               const std::function<void()> &task) {
+  std::thread thread([node, &task]() {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu: GetTopology().node_cpus[node])
+      CPU_SET(cpu, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    task();
+  });
+  thread.join();
+}
+
+void Interleave(const void *addr,
+                size_t num_bytes) {
+  const vec_uint32_t &node_ids = GetTopology().node_ids;
+  if (node_ids.size() == 1)
+    return;
+  // mbind takes whole pages, the pages the range shares with its neighbours stay where they are
+  auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = (reinterpret_cast<uintptr_t>(addr) + page_size - 1) / page_size * page_size;
+  auto end = (reinterpret_cast<uintptr_t>(addr) + num_bytes) / page_size * page_size;
+  if (begin >= end)
+    return;
+  const uint32_t NumBitsPerMaskWord = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> node_mask(node_ids.back() / NumBitsPerMaskWord + 1, 0);
+  for (auto node_id: node_ids)
+    node_mask[node_id / NumBitsPerMaskWord] |= 1ul << (node_id % NumBitsPerMaskWord);
+  syscall(SYS_mbind, reinterpret_cast<void *>(begin), end - begin, MPOL_INTERLEAVE, node_mask.data(),
+          node_mask.size() * NumBitsPerMaskWord, MPOL_MF_MOVE);
+}
+} // namespace Numa
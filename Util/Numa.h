@@ -0,0 +1,47 @@
+
+#ifndef DECISIONTREE_NUMA_H
+#define DECISIONTREE_NUMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "../Generics/TypeDefs.h"
+
+/// Memory nodes of the machine as the kernel reports them under /sys/devices/system/node,
+/// a machine without that report is one node with every CPU.
+/// Placement goes through the mbind system call, so no NUMA library is needed, and a placement the kernel refuses
+/// leaves the memory where it was.
+namespace Numa {
+
+uint32_t NumNodes();
+
+const vec_uint32_t &NodeCpus(uint32_t node);
+
+/// Node of the CPU the calling thread is on at the moment
+uint32_t CurrentNode();
+
+/// CurrentNode of the calling thread as of its first call, or of its first call since threads were last pinned.
+/// Cheap enough for every feature lookup. A thread that is not pinned may have moved since, which costs remote
+/// reads but no wrong results.
+uint32_t ThreadNode();
+
+/// Node of the page holding addr, or NumNodes() if the kernel cannot tell
+uint32_t NodeOfAddress(const void *addr);
+
+/// CPU for the thread_idx-th pinned thread: threads alternate between nodes, and go through the CPUs of each node
+uint32_t SpreadCpu(uint32_t thread_idx);
+
+void PinToCpu(std::thread &thread,
+              uint32_t cpu);
+
+/// Run task on a thread pinned to the CPUs of node, memory the task writes first is allocated on that node
+void RunOnNode(uint32_t node,
+               const std::function<void()> &task);
+
+/// Spread the pages of a range across all nodes, round robin, moving those already allocated
+void Interleave(const void *addr,
+                size_t num_bytes);
+} // namespace Numa
+
+#endif
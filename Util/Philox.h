@@ -0,0 +1,88 @@
+
+#ifndef DECISIONTREE_PHILOX_H
+#define DECISIONTREE_PHILOX_H
+
+#include <cstdint>
+
+/// Philox4x32-10 counter-based generator (Salmon et al., Parallel Random Numbers: As Easy as 1, 2, 3).
+/// The output is a function of the key, the stream and how many numbers were drawn, so a generator made anywhere
+/// from the same key and stream draws the same numbers, with no state shared between threads.
+class Philox {
+ public:
+  using result_type = uint32_t;
+
+  Philox(uint64_t key,
+         uint64_t stream):
+    key{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)},
+    counter{0, 0, static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)}, block(), block_idx(4) {}
+
+  static constexpr result_type min() {
+    return 0;
+  }
+
+  static constexpr result_type max() {
+    return UINT32_MAX;
+  }
+
+  result_type operator()() {
+    if (block_idx == 4) {
+      NextBlock();
+      block_idx = 0;
+    }
+    return block[block_idx++];
+  }
+
+  /// Uniform in [0, n) for n > 0, without modulo bias (Lemire, Fast Random Integer Generation in an Interval)
+  uint32_t Uniform(uint32_t n) {
+    uint64_t product = static_cast<uint64_t>(operator()()) * n;
+    if (static_cast<uint32_t>(product) < n) {
+      uint32_t threshold = (0u - n) % n;
+      while (static_cast<uint32_t>(product) < threshold)
+        product = static_cast<uint64_t>(operator()()) * n;
+    }
+    return static_cast<uint32_t>(product >> 32);
+  }
+
+  /// The block of four numbers for a counter, the first two counter words count blocks within the stream
+  static void Block(const uint32_t key[2],
+                    const uint32_t counter[4],
+                    uint32_t output[4]) {
+    uint32_t round_key[2] = {key[0], key[1]};
+    for (uint32_t idx = 0; idx != 4; ++idx)
+      output[idx] = counter[idx];
+    for (uint32_t round = 0; round != NumRounds; ++round) {
+      if (round != 0) {
+        round_key[0] += Weyl0;
+        round_key[1] += Weyl1;
+      }
+      uint64_t product0 = static_cast<uint64_t>(Multiplier0) * output[0];
+      uint64_t product1 = static_cast<uint64_t>(Multiplier1) * output[2];
+      uint32_t next[4] = {static_cast<uint32_t>(product1 >> 32) ^ output[1] ^ round_key[0],
+                          static_cast<uint32_t>(product1),
+                          static_cast<uint32_t>(product0 >> 32) ^ output[3] ^ round_key[1],
+                          static_cast<uint32_t>(product0)};
+      for (uint32_t idx = 0; idx != 4; ++idx)
+        output[idx] = next[idx];
+    }
+  }
+
+ private:
+  static const uint32_t NumRounds = 10;
+  static const uint32_t Multiplier0 = 0xD2511F53;
+  static const uint32_t Multiplier1 = 0xCD9E8D57;
+  static const uint32_t Weyl0 = 0x9E3779B9;
+  static const uint32_t Weyl1 = 0xBB67AE85;
+
+  const uint32_t key[2];
+  uint32_t counter[4];
+  uint32_t block[4];
+  uint32_t block_idx;
+
+  void NextBlock() {
+    Block(key, counter, block);
+    if (++counter[0] == 0)
+      ++counter[1];
+  }
+};
+
+#endif
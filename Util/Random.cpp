@@ -1,21 +1,52 @@
 
+#include <array>
+#include <cmath>
+#include <random>
 #include "Random.h"
 
 namespace Random {
 
-std::mt19937 random_generator;
-
-void Init(uint32_t random_state) {
-  random_generator.seed(random_state);
-}
-
 void SampleWithReplacement(uint32_t n,
                            uint32_t k,
-                           vec_uint32_t &histogram) {
-  std::uniform_int_distribution<uint32_t> distribution(0, n - 1);
+                           uint8_t *histogram,
+                           Philox &generator) {
   for (uint32_t i = 0; i != k; ++i) {
-    uint32_t next_random = distribution(random_generator);
-    ++histogram[next_random];
+    uint8_t &count = histogram[generator.Uniform(n)];
+    if (count != UINT8_MAX)
+      ++count;
+  }
+}
+
+void SamplePoisson(uint32_t n,
+                   uint8_t *histogram,
+                   Philox &generator) {
+  // the Poisson(1) distribution function in 32-bit fixed point, beyond count 12 it rounds to 1
+  static const uint32_t NumThresholds = 13;
+  static const std::array<uint64_t, NumThresholds> thresholds = [] {
+    std::array<uint64_t, NumThresholds> cumulative{};
+    double probability = std::exp(-1.0), sum = probability;
+    for (uint32_t count = 0; count != NumThresholds; ++count) {
+      cumulative[count] = static_cast<uint64_t>(std::ldexp(sum, 32));
+      probability /= count + 1;
+      sum += probability;
+    }
+    return cumulative;
+  }();
+  for (uint32_t i = 0; i != n; ++i) {
+    uint32_t u = generator();
+    uint32_t count = 0;
+    while (count != NumThresholds && u >= thresholds[count])
+      ++count;
+    histogram[i] = static_cast<uint8_t>(count);
   }
 }
+
+uint32_t Binomial(uint32_t n,
+                  double p,
+                  Philox &generator) {
+  if (p >= 1.0)
+    return n;
+  std::binomial_distribution<uint32_t> distribution(n, p);
+  return distribution(generator);
+}
 } // namespace Random
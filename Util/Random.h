@@ -2,26 +2,59 @@
 #ifndef DECISIONTREE_RANDOM_H
 #define DECISIONTREE_RANDOM_H
 
-#include <random>
 #include <vector>
 #include "../Generics/TypeDefs.h"
+#include "Philox.h"
 
+/// Random draws come from Philox streams named by what they are for, a tree node or the bootstrap of a tree,
+/// never from a generator shared by the workers. A build draws the same numbers for any number of workers.
 namespace Random {
 
-extern std::mt19937 random_generator;
+/// SplitMix64 finalizer, spreads a key over all 64 bits
+inline uint64_t Mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+/// Stream for the draws numbered index under a key, e.g. of one feature of a node
+inline uint64_t Stream(uint64_t key,
+                       uint64_t index) {
+  return Mix(key + Mix(index + 1));
+}
+
+/// Key of a child node from the key of its parent, so a node is named by its path from the root
+inline uint64_t ChildKey(uint64_t parent_key,
+                         bool is_right) {
+  return Mix(2 * parent_key + (is_right? 1 : 0));
+}
+
+/// Stream of the bootstrap of a tree, kept apart from the streams of its nodes
+static const uint64_t BootstrapStream = UINT64_MAX;
 
-void Init(uint32_t random_state);
+/// Add k draws with replacement out of n to the counts in histogram, the counts saturate at UINT8_MAX
 void SampleWithReplacement(uint32_t n,
                            uint32_t k,
-                           vec_uint32_t &histogram);
+                           uint8_t *histogram,
+                           Philox &generator);
+
+/// An independent Poisson(1) count for each of n samples, by inversion of one 32-bit draw
+void SamplePoisson(uint32_t n,
+                   uint8_t *histogram,
+                   Philox &generator);
+
+/// Number of successes in n trials with success probability p
+uint32_t Binomial(uint32_t n,
+                  double p,
+                  Philox &generator);
 
 static void PartialShuffle(uint32_t n,
                            uint32_t k,
-                           vec_uint32_t &target) {
+                           vec_uint32_t &target,
+                           Philox &generator) {
   if (n == k) return;
-  std::uniform_int_distribution<uint32_t> distribution(0, UINT32_MAX);
   for (uint32_t idx = 0; idx != k; ++idx) {
-    uint32_t next_random = (distribution(random_generator) % n) + idx;
+    uint32_t next_random = generator.Uniform(n) + idx;
     uint32_t temp = target[idx];
     target[idx] = target[next_random];
     target[next_random] = temp;